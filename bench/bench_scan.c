@@ -0,0 +1,154 @@
+// Tag scan microbenchmark: '<'-at-a-time dispatch vs the multi-pattern
+// candidate kernel, and parse_sgml with and without the <TEXT> skip-ahead,
+// on a synthetic HTML-heavy submission.
+//
+// Build: gcc -O3 -pthread -Isrc -o bench_scan bench/bench_scan.c src/secsgml.c src/uudecode.c src/scan.c src/simd.c src/sgml_alloc.c
+// Usage: bench_scan [size_mb] [iterations]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "secsgml.h"
+#include "scan.h"
+#include "simd.h"
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+static uint32_t rng = 12345;
+static uint32_t next_rand(void) {
+    rng = rng * 1103515245u + 12345u;
+    return rng >> 8;
+}
+
+// Table-heavy HTML as EDGAR 10-K exhibits look: mixed-case markup, short
+// cells, a '<' every few bytes.
+static const char *const MARKUP[] = {
+    "<tr>", "</tr>", "<td style=\"width:10%\">", "</td>", "<p>", "</p>",
+    "<span>", "</span>", "<TD>", "</TD>", "<TR>", "</TR>", "<FONT SIZE=2>",
+    "</FONT>", "<DIV>", "</DIV>", "<B>", "</B>", "<br>", "<table>", "</table>",
+    "<TABLE>", "<CAPTION>", "<S>", "<C>", "<PAGE>", "<DEI:DocumentType>", "<SEC-HEADER>",
+};
+#define MARKUP_COUNT (sizeof(MARKUP) / sizeof(MARKUP[0]))
+
+static size_t append(char *buf, size_t n, const char *s) {
+    size_t len = strlen(s);
+    memcpy(buf + n, s, len);
+    return n + len;
+}
+
+static char *make_filing(size_t target, size_t *out_len) {
+    char *buf = (char *)malloc(target + 4096);
+    size_t n = 0;
+    int doc = 0;
+    while (n < target) {
+        char head[256];
+        snprintf(head, sizeof(head),
+                 "<DOCUMENT>\n<TYPE>EX-%d\n<SEQUENCE>%d\n<FILENAME>ex%d.htm\n"
+                 "<DESCRIPTION>EXHIBIT\n<TEXT>\n<HTML><BODY>\n", doc, doc + 1, doc);
+        n = append(buf, n, head);
+        size_t body_end = n + (256u << 10);
+        if (body_end > target) body_end = target;
+        while (n < body_end) {
+            n = append(buf, n, MARKUP[next_rand() % MARKUP_COUNT]);
+            int words = (int)(next_rand() % 4);
+            for (int w = 0; w < words; w++) n = append(buf, n, "1,234 ");
+            if (next_rand() % 8 == 0) buf[n++] = '\n';
+        }
+        n = append(buf, n, "\n</BODY></HTML>\n</TEXT>\n</DOCUMENT>\n");
+        doc++;
+    }
+    *out_len = n;
+    return buf;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Every '<' visited, then a dispatch on the next byte -- the old loop
+static size_t scan_lt(sgml_find_lt_fn find_lt, const uint8_t *p, const uint8_t *end) {
+    size_t hits = 0;
+    while ((p = find_lt(p, end)) != NULL) {
+        uint8_t c1 = p + 1 < end ? p[1] : 0;
+        if (c1 == 'D' || c1 == 'T' || c1 == 'S' || c1 == 'F' || c1 == '/') hits++;
+        p++;
+    }
+    return hits;
+}
+
+static size_t scan_tag(sgml_find_lt_fn find_tag, const uint8_t *p, const uint8_t *end) {
+    size_t hits = 0;
+    while ((p = find_tag(p, end)) != NULL) {
+        hits++;
+        p++;
+    }
+    return hits;
+}
+
+int main(int argc, char **argv) {
+    size_t size_mb = argc > 1 ? (size_t)atoi(argv[1]) : 64;
+    int iters = argc > 2 ? atoi(argv[2]) : 11;
+    if (iters < 1) iters = 1;
+
+    size_t len;
+    char *filing = make_filing(size_mb << 20, &len);
+    const uint8_t *buf = (const uint8_t *)filing;
+    sgml_find_lt_fn find_lt  = sgml_select_find_lt();
+    sgml_find_lt_fn find_tag = sgml_select_find_tag();
+
+    double *t_lt  = (double *)malloc((size_t)iters * sizeof(double));
+    double *t_tag = (double *)malloc((size_t)iters * sizeof(double));
+    double *t_doc = (double *)malloc((size_t)iters * sizeof(double));
+    double *t_noskip = (double *)malloc((size_t)iters * sizeof(double));
+    sgml_parse_options noskip = {0};
+    noskip.no_text_skip = 1;
+    size_t visits_lt = 0, visits_tag = 0, docs = 0;
+
+    for (int i = 0; i < iters; i++) {
+        double t0 = now_ms();
+        visits_lt = scan_lt(find_lt, buf, buf + len);
+        double t1 = now_ms();
+        visits_tag = scan_tag(find_tag, buf, buf + len);
+        double t2 = now_ms();
+        sgml_parse_result r = parse_sgml(buf, len, NULL);
+        double t3 = now_ms();
+        docs = r.doc_count;
+        parse_sgml_into(&r, buf, len, &noskip, NULL);
+        double t4 = now_ms();
+        free_sgml_parse_result(&r);
+        t_lt[i] = t1 - t0;
+        t_tag[i] = t2 - t1;
+        t_doc[i] = t3 - t2;
+        t_noskip[i] = t4 - t3;
+    }
+    qsort(t_lt, (size_t)iters, sizeof(double), cmp_double);
+    qsort(t_tag, (size_t)iters, sizeof(double), cmp_double);
+    qsort(t_doc, (size_t)iters, sizeof(double), cmp_double);
+    qsort(t_noskip, (size_t)iters, sizeof(double), cmp_double);
+
+    double gb = (double)len / 1e9;
+    printf("input: %.1f MB, %zu documents, simd %s, median of %d\n",
+           (double)len / 1e6, docs, sgml_simd_name(sgml_simd_active()), iters);
+    printf("  find_lt loop:   %8.3f ms  %6.2f GB/s  (%zu candidates)\n",
+           t_lt[iters / 2], gb / (t_lt[iters / 2] / 1000.0), visits_lt);
+    printf("  find_tag loop:  %8.3f ms  %6.2f GB/s  (%zu candidates)\n",
+           t_tag[iters / 2], gb / (t_tag[iters / 2] / 1000.0), visits_tag);
+    printf("  parse_sgml:     %8.3f ms  %6.2f GB/s\n",
+           t_doc[iters / 2], gb / (t_doc[iters / 2] / 1000.0));
+    printf("  (no_text_skip): %8.3f ms  %6.2f GB/s\n",
+           t_noskip[iters / 2], gb / (t_noskip[iters / 2] / 1000.0));
+
+    free(t_lt);
+    free(t_tag);
+    free(t_doc);
+    free(t_noskip);
+    free(filing);
+    return 0;
+}
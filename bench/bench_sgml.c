@@ -0,0 +1,364 @@
+// End-to-end benchmark on a deterministic synthetic corpus: per-stage median
+// and p99 (slowest 1%) throughput across files, and allocations per file.
+//
+// Build: gcc -O3 -pthread -Isrc -o bench_sgml bench/bench_sgml.c bench/gen.c src/secsgml.c src/uudecode.c src/scan.c src/simd.c src/sgml_alloc.c src/standardize_submission_metadata.c src/sgml_output.c
+// Usage: bench_sgml [--files N] [--seed S] [--scale X] [--iters K]
+//                   [--out-dir DIR] [--json PATH]
+//
+// Each file is timed --iters times per stage and its fastest run kept, so a
+// stage's median/p99 are over files, not over noise. Header stages
+// (metadata, standardize, JSON, writers) are reported against header bytes,
+// uudecode against encoded bytes, everything else against file bytes.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "gen.h"
+#include "secsgml.h"
+#include "sgml_output.h"
+#include "simd.h"
+#include "standardize_submission_metadata.h"
+
+#ifdef _WIN32
+#define NULL_DEVICE "NUL"
+#else
+#define NULL_DEVICE "/dev/null"
+#endif
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// ---------------------------------------------------------------------------
+// Counting allocator -- malloc underneath, counts calls and bytes
+// ---------------------------------------------------------------------------
+typedef struct {
+    size_t calls;
+    size_t bytes;
+} alloc_count;
+
+static void *count_alloc(void *ctx, size_t size) {
+    alloc_count *c = (alloc_count *)ctx;
+    c->calls++;
+    c->bytes += size;
+    return malloc(size);
+}
+
+static void *count_realloc(void *ctx, void *ptr, size_t old_size, size_t new_size) {
+    alloc_count *c = (alloc_count *)ctx;
+    c->calls++;
+    if (new_size > old_size) c->bytes += new_size - old_size;
+    return realloc(ptr, new_size);
+}
+
+static void count_free(void *ctx, void *ptr) {
+    (void)ctx;
+    free(ptr);
+}
+
+// ---------------------------------------------------------------------------
+// Stages
+// ---------------------------------------------------------------------------
+enum {
+    STAGE_PARSE,
+    STAGE_PARSE_SUBMISSION,
+    STAGE_PARSE_LAZY,
+    STAGE_INDEX,
+    STAGE_UUDECODE,
+    STAGE_METADATA,
+    STAGE_STANDARDIZE,
+    STAGE_JSON,
+    STAGE_JSON_UTF8,
+    STAGE_WRITERS,
+    STAGE_WRITE_OUTPUTS,
+    STAGE_COUNT
+};
+
+static const char *const STAGE_NAMES[STAGE_COUNT] = {
+    "parse_sgml", "parse_submission", "parse_sgml_lazy", "parse_sgml_index", "uudecode",
+    "parse_submission_metadata",
+    "standardize", "submission_json", "submission_json_utf8", "json_csv_writers",
+    "write_outputs",
+};
+
+typedef struct {
+    double *gbps;   // one sample per file
+    size_t  count;
+    double  median;
+    double  p99;    // throughput the slowest 1% of files fall below
+} stage_stats;
+
+static void add_sample(stage_stats *s, size_t bytes, double ms) {
+    if (bytes == 0 || ms <= 0.0) return;
+    s->gbps[s->count++] = (double)bytes / 1e9 / (ms / 1000.0);
+}
+
+static void finish_stats(stage_stats *s) {
+    if (s->count == 0) return;
+    qsort(s->gbps, s->count, sizeof(double), cmp_double);
+    s->median = s->gbps[s->count / 2];
+    s->p99    = s->gbps[(s->count - 1) / 100];
+}
+
+// Offset of the first <DOCUMENT>, i.e. how much of the file is header
+static size_t header_bytes(const uint8_t *buf, size_t len) {
+    static const char tag[] = "<DOCUMENT>";
+    for (size_t i = 0; i + sizeof(tag) - 1 <= len; i++) {
+        if (buf[i] == '<' && memcmp(buf + i, tag, sizeof(tag) - 1) == 0) return i;
+    }
+    return len;
+}
+
+static void usage(void) {
+    fprintf(stderr, "Usage: bench_sgml [--files N] [--seed S] [--scale X] [--iters K]\n"
+                    "                  [--out-dir DIR] [--json PATH]\n");
+}
+
+int main(int argc, char **argv) {
+    size_t files = 50;
+    uint64_t seed = 1;
+    double scale = 1.0;
+    int iters = 3;
+    const char *out_dir = NULL;
+    const char *json_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        if (strcmp(arg, "--files") == 0)        files = (size_t)strtoull(argv[++i], NULL, 10);
+        else if (strcmp(arg, "--seed") == 0)    seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(arg, "--scale") == 0)   scale = atof(argv[++i]);
+        else if (strcmp(arg, "--iters") == 0)   iters = atoi(argv[++i]);
+        else if (strcmp(arg, "--out-dir") == 0) out_dir = argv[++i];
+        else if (strcmp(arg, "--json") == 0)    json_path = argv[++i];
+        else {
+            usage();
+            return 1;
+        }
+    }
+    if (files == 0) files = 1;
+    if (iters < 1) iters = 1;
+    if (scale <= 0.0) scale = 1.0;
+    if (out_dir && sgml_make_dir(out_dir) != 0) {
+        fprintf(stderr, "Error: cannot create %s\n", out_dir);
+        return 1;
+    }
+
+    stage_stats stats[STAGE_COUNT];
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        memset(&stats[s], 0, sizeof(stats[s]));
+        stats[s].gbps = (double *)malloc(files * sizeof(double));
+    }
+
+    FILE *null_out = fopen(NULL_DEVICE, "wb");
+    if (!null_out) {
+        fprintf(stderr, "Error: cannot open %s\n", NULL_DEVICE);
+        return 1;
+    }
+
+    sgml_parse_options eager = {0};
+    eager.decode_threads = 1;
+    sgml_parse_options lazy = eager;
+    lazy.lazy_decode = 1;
+
+    size_t total_bytes = 0, total_docs = 0;
+    alloc_count allocs = {0};
+    uint8_t *decode_buf = NULL;
+    size_t decode_cap = 0;
+    sgml_doc_index ix = {0};  // reused across files, as a batch worker would
+
+    for (size_t f = 0; f < files; f++) {
+        gen_params gp;
+        gen_corpus_params(seed, f, scale, &gp);
+        size_t len;
+        char *text = gen_submission(seed + f, &gp, &len);
+        const uint8_t *buf = (const uint8_t *)text;
+        size_t hdr = header_bytes(buf, len);
+        total_bytes += len;
+
+        double best[STAGE_COUNT];
+        for (int s = 0; s < STAGE_COUNT; s++) best[s] = 1e300;
+        size_t encoded_bytes = 0;
+
+        for (int it = 0; it < iters; it++) {
+            sgml_parse_result r = {0};
+            double t0 = now_ms();
+            parse_sgml_into(&r, buf, len, &eager, NULL);
+            double t1 = now_ms();
+            if (t1 - t0 < best[STAGE_PARSE]) best[STAGE_PARSE] = t1 - t0;
+
+            // Header and documents together, one pass
+            submission_metadata cm = {0};
+            t0 = now_ms();
+            parse_submission_into(&r, &cm, buf, len, &eager, NULL);
+            t1 = now_ms();
+            if (t1 - t0 < best[STAGE_PARSE_SUBMISSION]) best[STAGE_PARSE_SUBMISSION] = t1 - t0;
+            free_submission_metadata(&cm);
+            free_sgml_parse_result(&r);
+
+            sgml_parse_result lr = {0};
+            t0 = now_ms();
+            parse_sgml_into(&lr, buf, len, &lazy, NULL);
+            t1 = now_ms();
+            if (t1 - t0 < best[STAGE_PARSE_LAZY]) best[STAGE_PARSE_LAZY] = t1 - t0;
+            if (it == 0) total_docs += lr.doc_count;
+
+            // Offsets only: lazy scan plus decoded sizes, no docs array
+            t0 = now_ms();
+            parse_sgml_index_into(&ix, buf, len, NULL);
+            t1 = now_ms();
+            if (t1 - t0 < best[STAGE_INDEX]) best[STAGE_INDEX] = t1 - t0;
+
+            // Decode every uuencoded payload into one reused buffer
+            encoded_bytes = 0;
+            double ms = 0.0;
+            for (size_t d = 0; d < lr.doc_count; d++) {
+                const document *doc = &lr.docs[d];
+                if (!doc->is_uuencoded) continue;
+                size_t need = sgml_decoded_size(doc);
+                if (need > decode_cap) {
+                    free(decode_buf);
+                    decode_cap = need;
+                    decode_buf = (uint8_t *)malloc(decode_cap);
+                }
+                size_t out_len;
+                t0 = now_ms();
+                sgml_decode_document_into(doc, decode_buf, decode_cap, &out_len);
+                ms += now_ms() - t0;
+                encoded_bytes += doc->content_len;
+            }
+            if (encoded_bytes && ms < best[STAGE_UUDECODE]) best[STAGE_UUDECODE] = ms;
+
+            submission_metadata m = {0};
+            t0 = now_ms();
+            parse_submission_metadata_into(&m, buf, len);
+            t1 = now_ms();
+            if (t1 - t0 < best[STAGE_METADATA]) best[STAGE_METADATA] = t1 - t0;
+
+            standardized_submission_metadata std = {0};
+            t0 = now_ms();
+            standardize_submission_metadata_into(&std, &m);
+            t1 = now_ms();
+            if (t1 - t0 < best[STAGE_STANDARDIZE]) best[STAGE_STANDARDIZE] = t1 - t0;
+
+            // JSON formatting alone, default escaping and UTF-8 passthrough,
+            // alternating which goes first so neither always runs cold
+            for (int k = 0; k < 2; k++) {
+                int u = (it + k) & 1;
+                sgml_output_options jo = {0};
+                jo.utf8 = u;
+                size_t json_len;
+                t0 = now_ms();
+                char *json = sgml_format_submission_json_ex(&std, &jo, &json_len);
+                t1 = now_ms();
+                int stage = u ? STAGE_JSON_UTF8 : STAGE_JSON;
+                if (t1 - t0 < best[stage]) best[stage] = t1 - t0;
+                free(json);
+            }
+
+            t0 = now_ms();
+            sgml_write_submission_json(null_out, &std);
+            sgml_write_document_csv(null_out, &lr);
+            fflush(null_out);
+            t1 = now_ms();
+            if (t1 - t0 < best[STAGE_WRITERS]) best[STAGE_WRITERS] = t1 - t0;
+
+            if (out_dir) {
+                sgml_parse_result er = {0};
+                parse_sgml_into(&er, buf, len, &eager, NULL);
+                char dir[4096];
+                snprintf(dir, sizeof(dir), "%s" PATH_SEP "%zu", out_dir, f);
+                t0 = now_ms();
+                sgml_write_outputs(dir, &er, &std);
+                t1 = now_ms();
+                if (t1 - t0 < best[STAGE_WRITE_OUTPUTS]) best[STAGE_WRITE_OUTPUTS] = t1 - t0;
+                free_sgml_parse_result(&er);
+            }
+
+            free_standardized_submission_metadata(&std);
+            free_submission_metadata(&m);
+            free_sgml_parse_result(&lr);
+        }
+
+        add_sample(&stats[STAGE_PARSE], len, best[STAGE_PARSE]);
+        add_sample(&stats[STAGE_PARSE_SUBMISSION], len, best[STAGE_PARSE_SUBMISSION]);
+        add_sample(&stats[STAGE_PARSE_LAZY], len, best[STAGE_PARSE_LAZY]);
+        add_sample(&stats[STAGE_INDEX], len, best[STAGE_INDEX]);
+        add_sample(&stats[STAGE_UUDECODE], encoded_bytes, best[STAGE_UUDECODE]);
+        add_sample(&stats[STAGE_METADATA], hdr, best[STAGE_METADATA]);
+        add_sample(&stats[STAGE_STANDARDIZE], hdr, best[STAGE_STANDARDIZE]);
+        add_sample(&stats[STAGE_JSON], hdr, best[STAGE_JSON]);
+        add_sample(&stats[STAGE_JSON_UTF8], hdr, best[STAGE_JSON_UTF8]);
+        add_sample(&stats[STAGE_WRITERS], hdr, best[STAGE_WRITERS]);
+        if (out_dir) add_sample(&stats[STAGE_WRITE_OUTPUTS], len, best[STAGE_WRITE_OUTPUTS]);
+
+        // Allocations of one eager parse + metadata + standardize through
+        // the default (malloc) path
+        sgml_allocator counting = { count_alloc, count_realloc, count_free, &allocs };
+        sgml_parse_result cr = {0};
+        cr.alloc = counting;
+        eager.allocator = &counting;
+        parse_sgml_into(&cr, buf, len, &eager, NULL);
+        eager.allocator = NULL;
+        submission_metadata cm = parse_submission_metadata_ex(buf, len, &counting);
+        standardized_submission_metadata cs = standardize_submission_metadata_ex(&cm, &counting);
+        free_standardized_submission_metadata(&cs);
+        free_submission_metadata(&cm);
+        free_sgml_parse_result(&cr);
+
+        free(text);
+    }
+    fclose(null_out);
+    free(decode_buf);
+    free_sgml_doc_index(&ix);
+
+    for (int s = 0; s < STAGE_COUNT; s++) finish_stats(&stats[s]);
+
+    printf("corpus: %zu files, %.1f MB, %zu documents, seed %llu, scale %.2f, simd %s, best of %d\n",
+           files, (double)total_bytes / 1e6, total_docs, (unsigned long long)seed, scale,
+           sgml_simd_name(sgml_simd_active()), iters);
+    printf("  %-26s %10s %10s\n", "stage", "median", "p99");
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        if (stats[s].count == 0) continue;
+        printf("  %-26s %6.2f GB/s %6.2f GB/s\n", STAGE_NAMES[s], stats[s].median, stats[s].p99);
+    }
+    printf("  allocations per file:      %.1f calls, %.1f KB\n",
+           (double)allocs.calls / (double)files, (double)allocs.bytes / (double)files / 1024.0);
+
+    if (json_path) {
+        FILE *jf = fopen(json_path, "w");
+        if (!jf) {
+            fprintf(stderr, "Error: cannot write %s\n", json_path);
+            return 1;
+        }
+        fprintf(jf, "{\"files\":%zu,\"bytes\":%zu,\"documents\":%zu,\"seed\":%llu,\"scale\":%g,"
+                    "\"iters\":%d,\"simd\":\"%s\",\"stages\":{",
+                files, total_bytes, total_docs, (unsigned long long)seed, scale, iters,
+                sgml_simd_name(sgml_simd_active()));
+        int first = 1;
+        for (int s = 0; s < STAGE_COUNT; s++) {
+            if (stats[s].count == 0) continue;
+            fprintf(jf, "%s\"%s\":{\"median_gbps\":%.4f,\"p99_gbps\":%.4f}", first ? "" : ",",
+                    STAGE_NAMES[s], stats[s].median, stats[s].p99);
+            first = 0;
+        }
+        fprintf(jf, "},\"allocs_per_file\":%.2f,\"alloc_bytes_per_file\":%.0f}\n",
+                (double)allocs.calls / (double)files, (double)allocs.bytes / (double)files);
+        fclose(jf);
+    }
+
+    for (int s = 0; s < STAGE_COUNT; s++) free(stats[s].gbps);
+    return 0;
+}
@@ -0,0 +1,123 @@
+// Header standardization microbenchmark: standardize_submission_metadata
+// alone, per event and per header byte, on real submissions given on the
+// command line (or the bench_sgml synthetic corpus when none are).
+//
+// Build: gcc -O3 -pthread -Isrc -o bench_standardize bench/bench_standardize.c bench/gen.c src/secsgml.c src/uudecode.c src/scan.c src/simd.c src/sgml_alloc.c src/standardize_submission_metadata.c
+// Usage: bench_standardize [--iters K] [file.txt ...]
+//
+// Each header is parsed once, then standardized --iters times into the same
+// result (arrays kept, as batch workers do) and its fastest run kept.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "gen.h"
+#include "secsgml.h"
+#include "standardize_submission_metadata.h"
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+static char *read_file(const char *path, size_t *out_len) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *buf = size >= 0 ? (char *)malloc((size_t)size + 1) : NULL;
+    if (buf && fread(buf, 1, (size_t)size, f) != (size_t)size) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    *out_len = buf ? (size_t)size : 0;
+    return buf;
+}
+
+// Offset of the first <DOCUMENT>, i.e. how much of the file is header
+static size_t header_bytes(const uint8_t *buf, size_t len) {
+    static const char tag[] = "<DOCUMENT>";
+    for (size_t i = 0; i + sizeof(tag) - 1 <= len; i++) {
+        if (buf[i] == '<' && memcmp(buf + i, tag, sizeof(tag) - 1) == 0) return i;
+    }
+    return len;
+}
+
+typedef struct {
+    size_t headers;
+    size_t events;
+    size_t bytes;
+    double ms;
+} totals;
+
+static void bench_one(const uint8_t *buf, size_t len, int iters, standardized_submission_metadata *std,
+                      totals *t) {
+    size_t hdr = header_bytes(buf, len);
+    submission_metadata m = parse_submission_metadata(buf, hdr);
+    if (m.count == 0) {
+        free_submission_metadata(&m);
+        return;
+    }
+    double best = 1e300;
+    for (int it = 0; it < iters; it++) {
+        double t0 = now_ms();
+        standardize_submission_metadata_into(std, &m);
+        double t1 = now_ms();
+        if (t1 - t0 < best) best = t1 - t0;
+    }
+    t->headers++;
+    t->events += m.count;
+    t->bytes += hdr;
+    t->ms += best;
+    free_submission_metadata(&m);
+}
+
+int main(int argc, char **argv) {
+    int iters = 200;
+    int first_file = 1;
+    if (argc > 2 && strcmp(argv[1], "--iters") == 0) {
+        iters = atoi(argv[2]);
+        first_file = 3;
+    }
+    if (iters < 1) iters = 1;
+
+    standardized_submission_metadata std = {0};
+    totals t = {0};
+    if (first_file < argc) {
+        for (int i = first_file; i < argc; i++) {
+            size_t len;
+            char *buf = read_file(argv[i], &len);
+            if (!buf) {
+                fprintf(stderr, "Error: cannot read %s\n", argv[i]);
+                continue;
+            }
+            bench_one((const uint8_t *)buf, len, iters, &std, &t);
+            free(buf);
+        }
+    } else {
+        for (size_t f = 0; f < 50; f++) {
+            gen_params gp;
+            gen_corpus_params(1, f, 0.01, &gp);
+            size_t len;
+            char *buf = gen_submission(1 + f, &gp, &len);
+            bench_one((const uint8_t *)buf, len, iters, &std, &t);
+            free(buf);
+        }
+    }
+    free_standardized_submission_metadata(&std);
+
+    if (t.events == 0) {
+        fprintf(stderr, "No header events\n");
+        return 1;
+    }
+    printf("%zu headers, %zu events, %.1f KB, best of %d\n",
+           t.headers, t.events, (double)t.bytes / 1024.0, iters);
+    printf("  standardize  %8.1f ns/event  %8.1f MB/s\n",
+           t.ms * 1e6 / (double)t.events, (double)t.bytes / 1e6 / (t.ms / 1000.0));
+    return 0;
+}
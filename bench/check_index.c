@@ -0,0 +1,408 @@
+// Index sidecar check: format round trip, cache invalidation and the
+// loader's bounds checks, on the bench_sgml synthetic corpus.
+//
+// Build: gcc -O2 -pthread -Isrc -o check_index bench/check_index.c bench/gen.c src/sgml_index.c src/sgml_file.c src/secsgml.c src/uudecode.c src/scan.c src/simd.c src/sgml_alloc.c
+// Usage: check_index [--files N] [--seed S] [--dir DIR]
+//
+// For each submission, written to DIR (default: the current directory):
+// - the sidecar sgml_index_build makes, written and loaded back, has the
+//   same entries, header events, identity and path as parse_submission_index_into
+//   on the file's bytes, and every document reads back as parse_sgml gives it
+// - sgml_index_cache_get misses, then hits; after a new mtime, a same-size
+//   edit with the mtime put back, an append, or a sidecar from another path
+//   it misses again and returns the new file's index
+// - a truncated sidecar, or one with a bad magic, version, count or offset,
+//   fails to load with -1; after random byte flips it either fails to load
+//   or every span still points inside it
+// Exits 1 if any check fails. Files it creates are removed at the end.
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "gen.h"
+#include "secsgml.h"
+#include "sgml_index.h"
+#include "uudecode.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                                   \
+    do {                                                   \
+        if (!(cond)) {                                     \
+            fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__); \
+            fprintf(stderr, __VA_ARGS__);                  \
+            fputc('\n', stderr);                           \
+            failures++;                                    \
+        }                                                  \
+    } while (0)
+
+// xorshift64*, as bench/gen.c
+static uint64_t rng_next(uint64_t *s) {
+    *s ^= *s >> 12;
+    *s ^= *s << 25;
+    *s ^= *s >> 27;
+    return *s * 2685821657736338717ull;
+}
+
+static int write_file(const char *path, const void *data, size_t len, const char *mode) {
+    FILE *f = fopen(path, mode);
+    if (!f) return -1;
+    int ok = fwrite(data, 1, len, f) == len;
+    if (fclose(f) != 0) ok = 0;
+    return ok ? 0 : -1;
+}
+
+static uint8_t *read_file(const char *path, size_t *out_len) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *buf = n >= 0 ? (uint8_t *)malloc((size_t)n + 1) : NULL;
+    if (buf && fread(buf, 1, (size_t)n, f) != (size_t)n) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    *out_len = (size_t)n;
+    return buf;
+}
+
+static int span_eq(byte_span a, byte_span b) {
+    return a.len == b.len && (a.len == 0 || memcmp(a.ptr, b.ptr, a.len) == 0);
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static void put_u64(uint8_t *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+// ---------------------------------------------------------------------------
+// Comparisons
+// ---------------------------------------------------------------------------
+
+// 1 if s holds the same index and header as the reference parse
+static int same_index(const sgml_sidecar *s, const sgml_doc_index *ix, const submission_metadata *m) {
+    if (s->index.doc_count != ix->doc_count || s->header.count != m->count) return 0;
+    for (size_t i = 0; i < ix->doc_count; i++) {
+        const sgml_index_entry *a = &s->index.docs[i], *b = &ix->docs[i];
+        if (a->doc_offset != b->doc_offset || a->text_offset != b->text_offset ||
+            a->text_end != b->text_end || a->content_offset != b->content_offset ||
+            a->content_len != b->content_len || a->decoded_size != b->decoded_size ||
+            a->is_uuencoded != b->is_uuencoded) return 0;
+        if (!span_eq(a->meta.type, b->meta.type) || !span_eq(a->meta.sequence, b->meta.sequence) ||
+            !span_eq(a->meta.filename, b->meta.filename) ||
+            !span_eq(a->meta.description, b->meta.description)) return 0;
+    }
+    for (size_t i = 0; i < m->count; i++) {
+        const submission_event *a = &s->header.events[i], *b = &m->events[i];
+        if (a->type != b->type || a->depth != b->depth || !span_eq(a->key, b->key) ||
+            !span_eq(a->value, b->value)) return 0;
+    }
+    return 1;
+}
+
+static int same_id(const sgml_file_id *a, const sgml_file_id *b) {
+    return a->size == b->size && a->mtime_ns == b->mtime_ns && a->content_hash == b->content_hash;
+}
+
+static int within(byte_span s, const uint8_t *base, size_t len) {
+    return s.len == 0 || (s.ptr >= base && s.len <= len && (size_t)(s.ptr - base) <= len - s.len);
+}
+
+// 1 if every span of a loaded sidecar points inside its len backing bytes
+static int spans_inside(const sgml_sidecar *s, size_t len) {
+    const uint8_t *base = s->index.backing;
+    if (!within(s->source, base, len)) return 0;
+    for (size_t i = 0; i < s->index.doc_count; i++) {
+        const document_meta *d = &s->index.docs[i].meta;
+        if (!within(d->type, base, len) || !within(d->sequence, base, len) ||
+            !within(d->filename, base, len) || !within(d->description, base, len)) return 0;
+    }
+    for (size_t i = 0; i < s->header.count; i++) {
+        if (!within(s->header.events[i].key, base, len) ||
+            !within(s->header.events[i].value, base, len)) return 0;
+    }
+    return 1;
+}
+
+// Every document read with one pread matches parse_sgml's content or decode
+static int documents_match(const sgml_file *f, const sgml_doc_index *ix, const uint8_t *buf) {
+    for (size_t i = 0; i < ix->doc_count; i++) {
+        const sgml_index_entry *e = &ix->docs[i];
+        size_t cap = sgml_index_document_size(e), n = 0;
+        uint8_t *got = (uint8_t *)malloc(cap ? cap : 1);
+        uint8_t *want = (uint8_t *)malloc(cap ? cap : 1);
+        int ok = got && want && sgml_index_read_document(f, e, got, cap, &n) == 0 && n == cap;
+        if (ok) {
+            const uint8_t *content = buf + e->content_offset;
+            if (e->is_uuencoded) ok = uudecode(content, (size_t)e->content_len, want, cap) == cap;
+            else                 memcpy(want, content, cap);
+            ok = ok && memcmp(got, want, cap) == 0;
+        }
+        free(got);
+        free(want);
+        if (!ok) return 0;
+    }
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Checks
+// ---------------------------------------------------------------------------
+
+// Reference index of path's current bytes; NULL if it can't be read
+static uint8_t *reference(const char *path, size_t *len, sgml_doc_index *ix, submission_metadata *m) {
+    uint8_t *buf = read_file(path, len);
+    if (buf) parse_submission_index_into(ix, m, buf, *len, NULL);
+    return buf;
+}
+
+// cache_get on path; expects a hit or a miss and the index of the file as it is now
+static void expect_cache(const char *path, int want_hit, const char *what) {
+    sgml_sidecar s = {0};
+    sgml_file f;
+    int hit = -1;
+    int r = sgml_index_cache_get(NULL, path, &s, &f, &hit);
+    CHECK(r == 0, "%s: cache_get %s failed", what, path);
+    if (r == 0) {
+        sgml_doc_index ix = {0};
+        submission_metadata m = {0};
+        size_t len;
+        uint8_t *buf = reference(path, &len, &ix, &m);
+        CHECK(hit == want_hit, "%s: expected a %s", what, want_hit ? "hit" : "miss");
+        CHECK(buf && same_index(&s, &ix, &m), "%s: index differs from the file", what);
+        sgml_file_id id;
+        CHECK(sgml_file_identify(&f, &id) == 0 && same_id(&s.id, &id), "%s: identity differs", what);
+        free(buf);
+        free_sgml_doc_index(&ix);
+        free_submission_metadata(&m);
+        sgml_file_close(&f);
+    }
+    sgml_sidecar_free(&s);
+}
+
+// Sets path's mtime, to the nanosecond
+static int set_mtime(const char *path, const struct timespec *mtime) {
+    struct timespec ts[2] = { { 0, UTIME_OMIT }, *mtime };
+    return utimensat(AT_FDCWD, path, ts, 0);
+}
+
+static void check_round_trip(const char *path, const char *side_path) {
+    sgml_doc_index ix = {0};
+    submission_metadata m = {0};
+    size_t len;
+    uint8_t *buf = reference(path, &len, &ix, &m);
+    CHECK(buf != NULL, "can't read %s", path);
+    if (!buf) return;
+
+    sgml_file f;
+    sgml_sidecar built = {0}, loaded = {0};
+    CHECK(sgml_file_open(&f, path) == 0, "can't open %s", path);
+    CHECK(sgml_index_build(&built, &f, path, NULL) == 0, "build failed");
+    CHECK(same_index(&built, &ix, &m), "built index differs from parse_submission_index_into");
+    CHECK(built.id.size == len && built.source.len == strlen(path) &&
+          memcmp(built.source.ptr, path, built.source.len) == 0, "built identity or path wrong");
+
+    CHECK(sgml_index_write(side_path, &built) == 0, "write failed");
+    CHECK(sgml_index_load(side_path, &loaded) == 0, "load failed");
+    CHECK(same_index(&loaded, &ix, &m), "loaded index differs from parse_submission_index_into");
+    CHECK(same_id(&loaded.id, &built.id) && span_eq(loaded.source, built.source),
+          "loaded identity or path differs");
+    CHECK(documents_match(&f, &loaded.index, buf), "read_document differs from parse_sgml");
+
+    sgml_file_close(&f);
+    sgml_sidecar_free(&built);
+    sgml_sidecar_free(&loaded);
+    free(buf);
+    free_sgml_doc_index(&ix);
+    free_submission_metadata(&m);
+}
+
+static void check_invalidation(const char *path, const char *other_path) {
+    char side[4096 + 16];
+    snprintf(side, sizeof(side), "%s.sgmlidx", path);
+    remove(side);
+    expect_cache(path, 0, "no sidecar");
+    expect_cache(path, 1, "unchanged");
+
+    struct stat st;
+    CHECK(stat(path, &st) == 0, "stat %s", path);
+    struct timespec later = st.st_mtim;
+    later.tv_sec += 1;
+    CHECK(set_mtime(path, &later) == 0, "utimensat %s", path);
+    expect_cache(path, 0, "new mtime");
+    expect_cache(path, 1, "new mtime, second lookup");
+
+    // Same size, same mtime: only the sampled content hash can tell
+    size_t len;
+    uint8_t *buf = read_file(path, &len);
+    CHECK(buf && len > 100, "can't read %s", path);
+    if (buf && len > 100) {
+        CHECK(stat(path, &st) == 0, "stat %s", path);
+        buf[len / 2] ^= 0x20;
+        buf[50] ^= 0x20;  // first sampled block, inside the header
+        CHECK(write_file(path, buf, len, "wb") == 0, "rewrite %s", path);
+        CHECK(set_mtime(path, &st.st_mtim) == 0, "utimensat %s", path);
+        expect_cache(path, 0, "same-size edit, mtime restored");
+        expect_cache(path, 1, "same-size edit, second lookup");
+    }
+    free(buf);
+
+    CHECK(write_file(path, "\n", 1, "ab") == 0, "append to %s", path);
+    expect_cache(path, 0, "appended");
+
+    // Another file's sidecar, even of identical bytes and a path of the
+    // same length, is not trusted
+    buf = read_file(path, &len);
+    char other_side[4096 + 16];
+    snprintf(other_side, sizeof(other_side), "%s.sgmlidx", other_path);
+    size_t side_len;
+    uint8_t *side_bytes = read_file(side, &side_len);
+    CHECK(buf && side_bytes, "can't read %s or its sidecar", path);
+    if (buf && side_bytes) {
+        CHECK(write_file(other_path, buf, len, "wb") == 0, "write %s", other_path);
+        struct stat ost;
+        CHECK(stat(path, &st) == 0 && set_mtime(other_path, &st.st_mtim) == 0 &&
+              stat(other_path, &ost) == 0, "copy mtime to %s", other_path);
+        CHECK(write_file(other_side, side_bytes, side_len, "wb") == 0, "write %s", other_side);
+        expect_cache(other_path, 0, "sidecar of another path");
+    }
+    free(buf);
+    free(side_bytes);
+    remove(other_side);
+    remove(other_path);
+    remove(side);
+}
+
+// Loads bytes as a sidecar from path; 0 or -1 as sgml_index_load
+static int load_bytes(const char *path, const uint8_t *bytes, size_t len, sgml_sidecar *s) {
+    if (write_file(path, bytes, len, "wb") != 0) return -2;
+    return sgml_index_load(path, s);
+}
+
+static void check_corrupt(const char *side_path, const char *bad_path, uint64_t *rng) {
+    size_t len;
+    uint8_t *good = read_file(side_path, &len);
+    CHECK(good && len >= SGML_INDEX_HEADER_SIZE, "can't read %s", side_path);
+    if (!good || len < SGML_INDEX_HEADER_SIZE) {
+        free(good);
+        return;
+    }
+    uint8_t *bad = (uint8_t *)malloc(len);
+    sgml_sidecar s = {0};
+    uint32_t docs = 0;
+    for (int i = 0; i < 4; i++) docs |= (uint32_t)good[12 + i] << (8 * i);
+
+    // Truncated anywhere: header, entries, events, strings, last byte
+    size_t cuts[] = { 0, 7, SGML_INDEX_HEADER_SIZE - 1, SGML_INDEX_HEADER_SIZE,
+                      SGML_INDEX_HEADER_SIZE + SGML_INDEX_ENTRY_SIZE / 2, len / 2, len - 1 };
+    for (size_t i = 0; i < sizeof(cuts) / sizeof(cuts[0]); i++) {
+        if (cuts[i] >= len) continue;
+        CHECK(load_bytes(bad_path, good, cuts[i], &s) == -1, "truncated to %zu of %zu bytes loaded",
+              cuts[i], len);
+    }
+
+    // One header or entry field at a time; some only matter with documents
+    struct { size_t off; int wide; uint64_t value; int needs_docs; const char *what; } edits[] = {
+        { 0,  1, 0x53474d4c49445858ull, 0, "magic" },
+        { 8,  0, SGML_INDEX_VERSION + 1, 0, "version" },
+        { 12, 0, 0xFFFFFFFFu, 0, "document count" },
+        { 40, 1, len, 0, "string table offset" },
+        { 48, 1, len, 0, "string table length" },
+        { 56, 0, 0xFFFFFFFFu, 0, "event count" },
+        { 60, 0, 0xFFFFFFF0u, 0, "source path offset" },
+        { 64, 0, 0xFFFFFFF0u, 0, "source path length" },
+        { 72, 1, len + 1, 0, "events offset" },
+        { 72, 1, SGML_INDEX_HEADER_SIZE, 1, "events offset over the entries" },
+        { 16, 1, 0, 1, "source size below a document's content" },
+        { SGML_INDEX_HEADER_SIZE + 24, 1, (uint64_t)-1 / 2, 1, "content offset" },
+        { SGML_INDEX_HEADER_SIZE + 56, 0, 0xFFFFFFF0u, 1, "TYPE offset" },
+        { SGML_INDEX_HEADER_SIZE + 60, 0, 0xFFFFFFF0u, 1, "TYPE length" },
+    };
+    for (size_t i = 0; i < sizeof(edits) / sizeof(edits[0]); i++) {
+        if (edits[i].needs_docs && docs == 0) continue;
+        memcpy(bad, good, len);
+        if (edits[i].wide) put_u64(bad + edits[i].off, edits[i].value);
+        else               put_u32(bad + edits[i].off, (uint32_t)edits[i].value);
+        CHECK(load_bytes(bad_path, bad, len, &s) == -1, "bad %s loaded", edits[i].what);
+    }
+
+    // Random flips: either rejected or every span still inside the sidecar
+    for (int i = 0; i < 200; i++) {
+        memcpy(bad, good, len);
+        for (int k = 1 + (int)(rng_next(rng) % 3); k > 0; k--) {
+            bad[rng_next(rng) % len] ^= (uint8_t)(1u << (rng_next(rng) % 8));
+        }
+        int r = load_bytes(bad_path, bad, len, &s);
+        CHECK(r == -1 || (r == 0 && spans_inside(&s, len)), "flipped sidecar loaded out of bounds");
+    }
+
+    // The good one still loads after all of the above reused s
+    CHECK(load_bytes(bad_path, good, len, &s) == 0, "valid sidecar rejected");
+    sgml_sidecar_free(&s);
+    free(bad);
+    free(good);
+    remove(bad_path);
+}
+
+static void usage(void) {
+    fprintf(stderr, "Usage: check_index [--files N] [--seed S] [--dir DIR]\n");
+}
+
+int main(int argc, char **argv) {
+    size_t files = 20;
+    uint64_t seed = 1;
+    const char *dir = ".";
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        if (strcmp(arg, "--files") == 0)     files = (size_t)strtoull(argv[++i], NULL, 10);
+        else if (strcmp(arg, "--seed") == 0) seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(arg, "--dir") == 0)  dir = argv[++i];
+        else {
+            usage();
+            return 1;
+        }
+    }
+
+    char path[4096], other[4096], side[4096], bad[4096];
+    snprintf(path, sizeof(path), "%s/check_index.txt", dir);
+    snprintf(other, sizeof(other), "%s/check_index.cpy", dir);
+    snprintf(side, sizeof(side), "%s/check_index.sgmlidx", dir);
+    snprintf(bad, sizeof(bad), "%s/check_index_bad.sgmlidx", dir);
+    uint64_t rng = seed * 0x9E3779B97F4A7C15ull + 1;
+
+    for (size_t f = 0; f < files; f++) {
+        gen_params gp;
+        gen_corpus_params(seed, f, 0.05, &gp);
+        size_t len;
+        char *text = gen_submission(seed + f, &gp, &len);
+        if (!text || write_file(path, text, len, "wb") != 0) {
+            fprintf(stderr, "Error: cannot write %s\n", path);
+            free(text);
+            return 1;
+        }
+        free(text);
+        int before = failures;
+        check_round_trip(path, side);
+        check_corrupt(side, bad, &rng);
+        check_invalidation(path, other);
+        if (failures != before) fprintf(stderr, "  (file %zu, seed %llu)\n", f, (unsigned long long)seed);
+    }
+    remove(path);
+    remove(side);
+
+    printf("%zu files: %s\n", files, failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
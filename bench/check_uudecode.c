@@ -0,0 +1,412 @@
+// uudecode check: every SIMD tier this CPU has against the scalar tier, on
+// randomized SEC-style payloads. The tier is fixed per process, so the check
+// runs itself once per tier with SECSGML_SIMD set and compares what each run
+// decoded byte for byte with the scalar run.
+//
+// Build: gcc -O2 -pthread -Isrc -o check_uudecode bench/check_uudecode.c src/uudecode.c src/simd.c
+// Usage: check_uudecode [--cases N] [--seed S]
+//
+// Payloads mix full 45-byte lines (SEC's stripped trailing spaces, or '`'
+// for zero), short and over-declared lines, lines with extra or missing
+// characters, stray bytes, CRLF, blank and zero-length lines, and runs long
+// enough for the multi-line kernels. Each one goes through uudecode_size,
+// uudecode with an exact and a truncating out_cap, uudecode_fused growing
+// and with a final cap, the planned parallel decode and the newline scan.
+// Exits 1 on the first difference, naming the case and the function.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simd.h"
+#include "uudecode.h"
+
+// xorshift64*, as bench/gen.c
+static uint64_t rng_next(uint64_t *s) {
+    *s ^= *s >> 12;
+    *s ^= *s << 25;
+    *s ^= *s >> 27;
+    return *s * 2685821657736338717ull;
+}
+
+static size_t rng_range(uint64_t *s, size_t lo, size_t hi) {
+    return hi > lo ? lo + (size_t)(rng_next(s) % (hi - lo + 1)) : lo;
+}
+
+typedef struct {
+    uint8_t *data;
+    size_t   len;
+    size_t   cap;
+} byte_buf;
+
+static void buf_put(byte_buf *b, const void *p, size_t len) {
+    if (b->len + len > b->cap) {
+        size_t cap = b->cap ? b->cap : 4096;
+        while (cap < b->len + len) cap *= 2;
+        b->data = (uint8_t *)realloc(b->data, cap);
+        if (!b->data) {
+            fprintf(stderr, "Error: out of memory\n");
+            exit(1);
+        }
+        b->cap = cap;
+    }
+    if (len) memcpy(b->data + b->len, p, len);
+    b->len += len;
+}
+
+// ---------------------------------------------------------------------------
+// Payloads
+// ---------------------------------------------------------------------------
+
+// One encoded line of n bytes, then the variations real filings have
+static void gen_line(byte_buf *b, uint64_t *s, size_t n, int crlf) {
+    uint8_t chunk[63];
+    char line[128];
+    int zeros = rng_next(s) % 6 == 0;
+    for (size_t i = 0; i < n; i++) chunk[i] = zeros ? 0 : (uint8_t)rng_next(s);
+    int grave = rng_next(s) % 4 == 0;  // '`' for zero instead of ' '
+    size_t w = 0;
+    line[w++] = (char)(n ? ' ' + n : (grave ? '`' : ' '));
+    for (size_t i = 0; i < n; i += 3) {
+        uint32_t v = (uint32_t)chunk[i] << 16;
+        if (i + 1 < n) v |= (uint32_t)chunk[i + 1] << 8;
+        if (i + 2 < n) v |= chunk[i + 2];
+        for (int k = 3; k >= 0; k--) {
+            uint32_t c = (v >> (6 * k)) & 0x3f;
+            line[w++] = (char)(c == 0 && grave ? '`' : ' ' + c);
+        }
+    }
+    switch (rng_next(s) % 8) {
+    case 0: case 1: case 2:  // SEC: trailing spaces stripped
+        while (w > 1 && line[w - 1] == ' ') w--;
+        break;
+    case 3:  // more characters than the length char asks for
+        for (size_t k = rng_range(s, 1, 24); k > 0; k--) line[w++] = (char)rng_range(s, 0x21, 0x60);
+        break;
+    case 4:  // fewer
+        if (w > 2) w -= rng_range(s, 1, w - 2);
+        break;
+    case 5:  // a stray byte outside the uuencode alphabet
+        if (w > 1) {
+            uint8_t c;
+            do c = (uint8_t)rng_next(s); while (c == '\n' || c == '\r');
+            line[rng_range(s, 1, w - 1)] = (char)c;
+        }
+        break;
+    default:
+        break;
+    }
+    buf_put(b, line, w);
+    buf_put(b, crlf ? "\r\n" : "\n", crlf ? 2 : 1);
+}
+
+// malloc'd payload of exactly *out_len bytes, so an overread shows under ASan
+static uint8_t *gen_payload(uint64_t *s, size_t *out_len) {
+    byte_buf b = {0};
+    int crlf = rng_next(s) % 4 == 0;
+    size_t lines;
+    switch (rng_next(s) % 20) {
+    case 0:                          lines = rng_range(s, 1000, 5000); break;
+    case 1: case 2: case 3:          lines = rng_range(s, 100, 1000);  break;
+    case 4: case 5: case 6: case 7:
+    case 8: case 9: case 10: case 11: lines = rng_range(s, 5, 100);    break;
+    default:                         lines = rng_range(s, 0, 4);       break;
+    }
+    int mostly_full = rng_next(s) % 4 != 0;
+    for (size_t i = 0; i < lines; i++) {
+        size_t n;
+        switch (rng_next(s) % 64) {
+        case 0:  n = 0; break;                      // zero-length line: stops decoding
+        case 1:  buf_put(&b, "\n", 1); continue;    // blank line
+        case 2:  n = rng_range(s, 46, 63); break;   // declares more than 45 bytes
+        default: n = mostly_full ? 45 : rng_range(s, 1, 45); break;
+        }
+        // The last line of a payload is usually short
+        if (i + 1 == lines && n == 45 && rng_next(s) % 2) n = rng_range(s, 1, 44);
+        gen_line(&b, s, n, crlf);
+    }
+    switch (rng_next(s) % 4) {
+    case 0:  // as in a document: terminator, "end", then the rest of the text
+        gen_line(&b, s, 0, crlf);
+        buf_put(&b, crlf ? "end\r\n</TEXT>\r\n" : "end\n</TEXT>\n", crlf ? 15 : 13);
+        break;
+    case 1:
+        buf_put(&b, crlf ? "end\r\n" : "end\n", crlf ? 5 : 4);
+        break;
+    case 2:  // no final newline
+        if (b.len && b.data[b.len - 1] == '\n') b.len--;
+        if (b.len && b.data[b.len - 1] == '\r') b.len--;
+        break;
+    default:
+        break;
+    }
+    uint8_t *p = (uint8_t *)malloc(b.len ? b.len : 1);
+    if (!p) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
+    if (b.len) memcpy(p, b.data, b.len);
+    *out_len = b.len;
+    free(b.data);
+    return p;
+}
+
+// ---------------------------------------------------------------------------
+// One tier: decode every case and write the results to stdout
+//
+// Records are [u32 case][u8 kind][u64 len][len bytes]; the first one is the
+// active tier.
+// ---------------------------------------------------------------------------
+enum {
+    REC_TIER,
+    REC_SIZE,
+    REC_DECODE,
+    REC_DECODE_CAP,
+    REC_FUSED,
+    REC_FUSED_LIMIT,
+    REC_PLANNED,
+    REC_NEWLINE,
+    REC_COUNT
+};
+
+static const char *const REC_NAMES[REC_COUNT] = {
+    "tier", "uudecode_size", "uudecode", "uudecode (truncating out_cap)", "uudecode_fused",
+    "uudecode_fused (final out_cap)", "uudecode_planned", "find_newline",
+};
+
+static void put_rec(byte_buf *o, uint32_t c, uint8_t kind, const void *p, uint64_t len) {
+    buf_put(o, &c, sizeof(c));
+    buf_put(o, &kind, 1);
+    buf_put(o, &len, sizeof(len));
+    buf_put(o, p, (size_t)len);
+}
+
+// Counters first, then the decoded bytes
+static void put_result(byte_buf *o, uint32_t c, uint8_t kind, const uint64_t *nums, size_t count,
+                       const uint8_t *out, size_t out_len) {
+    byte_buf r = {0};
+    buf_put(&r, nums, count * sizeof(uint64_t));
+    buf_put(&r, out, out_len);
+    put_rec(o, c, kind, r.data, r.len);
+    free(r.data);
+}
+
+// Exactly cap bytes, so an overrun shows under ASan
+static uint8_t *out_alloc(size_t cap) {
+    uint8_t *p = (uint8_t *)malloc(cap ? cap : 1);
+    if (!p) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
+    return p;
+}
+
+static void run_case(byte_buf *o, uint32_t c, uint64_t *s, const uint8_t *in, size_t len) {
+    uint64_t size = uudecode_size(in, len);
+    put_rec(o, c, REC_SIZE, &size, sizeof(size));
+
+    uint8_t *out = out_alloc((size_t)size);
+    uint64_t n = uudecode(in, len, out, (size_t)size);
+    put_result(o, c, REC_DECODE, &n, 1, out, (size_t)n);
+    free(out);
+
+    size_t cap = rng_range(s, 0, size ? (size_t)size - 1 : 0);
+    out = out_alloc(cap);
+    n = uudecode(in, len, out, cap);
+    put_result(o, c, REC_DECODE_CAP, &n, 1, out, (size_t)n);
+    free(out);
+
+    // Growing: start small and double on UU_FUSED_FULL, as parse_sgml does
+    uu_fused_state st = {0};
+    cap = rng_range(s, 0, 256);
+    out = out_alloc(cap);
+    uint64_t calls = 0;
+    while (uudecode_fused(in, len, out, cap, 0, &st) == UU_FUSED_FULL) {
+        calls++;
+        cap = cap * 2 + 64;
+        uint8_t *grown = out_alloc(cap);
+        memcpy(grown, out, st.out_pos);
+        free(out);
+        out = grown;
+    }
+    uint64_t fused[4] = { st.out_pos, st.enc_len, (uint64_t)st.truncated, calls };
+    put_result(o, c, REC_FUSED, fused, 4, out, st.out_pos);
+    free(out);
+
+    memset(&st, 0, sizeof(st));
+    cap = rng_range(s, 0, (size_t)size);
+    out = out_alloc(cap);
+    int r = uudecode_fused(in, len, out, cap, 1, &st);
+    uint64_t limit[4] = { st.out_pos, st.enc_len, (uint64_t)st.truncated, (uint64_t)r };
+    put_result(o, c, REC_FUSED_LIMIT, limit, 4, out, st.out_pos);
+    free(out);
+
+    uu_plan plan;
+    uint64_t total = uu_plan_segments(&plan, in, len, (int)rng_range(s, 1, 4));
+    out = out_alloc((size_t)total);
+    n = uudecode_planned(&plan, out, (size_t)total);
+    uint64_t planned[2] = { total, n };
+    put_result(o, c, REC_PLANNED, planned, 2, out, (size_t)n);
+    free(out);
+
+    // Offsets of every line end from a few starting points
+    uu_find_newline_fn find_nl = uu_select_find_newline();
+    byte_buf nl = {0};
+    for (int k = 0; k < 4; k++) {
+        const uint8_t *p = in + rng_range(s, 0, len);
+        for (int lines = 0; lines < 64 && p < in + len; lines++) {
+            p = find_nl(p, in + len);
+            uint64_t off = (uint64_t)(p - in);
+            buf_put(&nl, &off, sizeof(off));
+            if (p < in + len) p++;
+        }
+    }
+    put_rec(o, c, REC_NEWLINE, nl.data, nl.len);
+    free(nl.data);
+}
+
+static int dump(size_t cases, uint64_t seed) {
+    byte_buf o = {0};
+    uint32_t tier = (uint32_t)sgml_simd_active();
+    put_rec(&o, 0, REC_TIER, &tier, sizeof(tier));
+    uint64_t s = seed * 0x9E3779B97F4A7C15ull + 1;
+    for (size_t c = 0; c < cases; c++) {
+        size_t len;
+        uint8_t *in = gen_payload(&s, &len);
+        run_case(&o, (uint32_t)c, &s, in, len);
+        free(in);
+    }
+    int ok = fwrite(o.data, 1, o.len, stdout) == o.len;
+    free(o.data);
+    return ok && fflush(stdout) == 0 ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------
+// Driver: one child per tier, compared with the scalar child
+// ---------------------------------------------------------------------------
+
+// Output of this program run with --dump under SECSGML_SIMD=tier
+static int run_tier(const char *self, sgml_simd_tier tier, size_t cases, uint64_t seed,
+                    byte_buf *out) {
+    char cmd[4096];
+    snprintf(cmd, sizeof(cmd), "'%s' --dump --cases %zu --seed %llu", self, cases,
+             (unsigned long long)seed);
+    setenv("SECSGML_SIMD", sgml_simd_name(tier), 1);
+    FILE *p = popen(cmd, "r");
+    if (!p) return -1;
+    uint8_t chunk[1 << 16];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), p)) > 0) buf_put(out, chunk, n);
+    return pclose(p) == 0 ? 0 : -1;
+}
+
+typedef struct {
+    uint32_t       c;
+    uint8_t        kind;
+    const uint8_t *data;
+    uint64_t       len;
+} rec;
+
+// Next record at *pos, or 0 at the end or on a malformed stream
+static int next_rec(const byte_buf *b, size_t *pos, rec *r) {
+    size_t head = sizeof(r->c) + 1 + sizeof(r->len);
+    if (b->len - *pos < head) return 0;
+    memcpy(&r->c, b->data + *pos, sizeof(r->c));
+    r->kind = b->data[*pos + sizeof(r->c)];
+    memcpy(&r->len, b->data + *pos + sizeof(r->c) + 1, sizeof(r->len));
+    if (r->kind >= REC_COUNT || b->len - *pos - head < r->len) return 0;
+    r->data = b->data + *pos + head;
+    *pos += head + (size_t)r->len;
+    return 1;
+}
+
+// 0 when every record of got matches want after the tier record
+static int compare(const byte_buf *want, const byte_buf *got, const char *tier) {
+    size_t wp = 0, gp = 0;
+    rec w, g;
+    if (!next_rec(want, &wp, &w) || !next_rec(got, &gp, &g)) {
+        fprintf(stderr, "%s: malformed output\n", tier);
+        return -1;
+    }
+    for (;;) {
+        int hw = next_rec(want, &wp, &w);
+        int hg = next_rec(got, &gp, &g);
+        if (!hw && !hg) return 0;
+        if (hw != hg || w.c != g.c || w.kind != g.kind) {
+            fprintf(stderr, "%s: output ends or is out of step at case %u\n", tier,
+                    hw ? w.c : g.c);
+            return -1;
+        }
+        if (w.len != g.len || memcmp(w.data, g.data, (size_t)w.len) != 0) {
+            fprintf(stderr, "%s: case %u: %s differs from scalar\n", tier, w.c, REC_NAMES[w.kind]);
+            return -1;
+        }
+    }
+}
+
+static void usage(void) {
+    fprintf(stderr, "Usage: check_uudecode [--cases N] [--seed S]\n");
+}
+
+int main(int argc, char **argv) {
+    size_t cases = 2000;
+    uint64_t seed = 1;
+    int dump_only = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (strcmp(arg, "--dump") == 0) {  // internal: one tier's results to stdout
+            dump_only = 1;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        if (strcmp(arg, "--cases") == 0)     cases = (size_t)strtoull(argv[++i], NULL, 10);
+        else if (strcmp(arg, "--seed") == 0) seed = strtoull(argv[++i], NULL, 10);
+        else {
+            usage();
+            return 1;
+        }
+    }
+    if (dump_only) return dump(cases, seed);
+
+    byte_buf ref = {0};
+    if (run_tier(argv[0], SGML_SIMD_SCALAR, cases, seed, &ref) != 0) {
+        fprintf(stderr, "Error: scalar run failed\n");
+        return 1;
+    }
+    printf("%zu cases, seed %llu, %zu bytes of results per tier\n", cases,
+           (unsigned long long)seed, ref.len);
+
+    sgml_simd_tier detected = sgml_simd_detect();
+    int failed = 0, checked = 0;
+    for (int t = SGML_SIMD_SSE2; t <= SGML_SIMD_NEON; t++) {
+        // Only tiers the override can select on this CPU
+        if ((t == SGML_SIMD_NEON) != (detected == SGML_SIMD_NEON) || t > (int)detected) continue;
+        const char *name = sgml_simd_name((sgml_simd_tier)t);
+        fflush(stdout);  // keep the report in order with errors on stderr
+        byte_buf got = {0};
+        size_t pos = 0;
+        rec first;
+        uint32_t active = 0;
+        if (run_tier(argv[0], (sgml_simd_tier)t, cases, seed, &got) != 0 ||
+            !next_rec(&got, &pos, &first) || first.len != sizeof(active)) {
+            fprintf(stderr, "%s: run failed\n", name);
+            failed = 1;
+        } else if (memcpy(&active, first.data, sizeof(active)), active != (uint32_t)t) {
+            printf("  %-10s  not selected (got %s), skipped\n", name,
+                   sgml_simd_name((sgml_simd_tier)active));
+        } else if (compare(&ref, &got, name) != 0) {
+            failed = 1;
+        } else {
+            printf("  %-10s  matches scalar\n", name);
+            checked++;
+        }
+        free(got.data);
+    }
+    free(ref.data);
+    if (!failed && checked == 0) printf("  no SIMD tier on this CPU\n");
+    return failed;
+}
@@ -0,0 +1,238 @@
+#include "gen.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ---------------------------------------------------------------------------
+// Output buffer and PRNG
+// ---------------------------------------------------------------------------
+typedef struct {
+    char  *data;
+    size_t len;
+    size_t cap;
+} gen_buf;
+
+static void buf_reserve(gen_buf *b, size_t extra) {
+    if (b->len + extra <= b->cap) return;
+    size_t cap = b->cap ? b->cap * 2 : 1u << 20;
+    while (cap < b->len + extra) cap *= 2;
+    char *tmp = (char *)realloc(b->data, cap);
+    if (!tmp) {
+        fprintf(stderr, "gen: out of memory\n");
+        exit(1);
+    }
+    b->data = tmp;
+    b->cap  = cap;
+}
+
+static void buf_put(gen_buf *b, const char *s, size_t len) {
+    buf_reserve(b, len);
+    memcpy(b->data + b->len, s, len);
+    b->len += len;
+}
+
+static void buf_puts(gen_buf *b, const char *s) {
+    buf_put(b, s, strlen(s));
+}
+
+static void buf_printf(gen_buf *b, const char *fmt, ...) {
+    char tmp[512];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(tmp, sizeof(tmp), fmt, ap);
+    va_end(ap);
+    if (n > 0) buf_put(b, tmp, (size_t)n < sizeof(tmp) ? (size_t)n : sizeof(tmp) - 1);
+}
+
+// xorshift64*, seeded per submission
+static uint64_t rng_next(uint64_t *s) {
+    *s ^= *s >> 12;
+    *s ^= *s << 25;
+    *s ^= *s >> 27;
+    return *s * 2685821657736338717ull;
+}
+
+static size_t rng_range(uint64_t *s, size_t lo, size_t hi) {
+    return hi > lo ? lo + (size_t)(rng_next(s) % (hi - lo + 1)) : lo;
+}
+
+// ---------------------------------------------------------------------------
+// Headers
+// ---------------------------------------------------------------------------
+static void gen_sec_header(gen_buf *b, uint64_t *s, int filers) {
+    unsigned acc = (unsigned)(rng_next(s) % 1000000);
+    buf_puts(b, "-----BEGIN PRIVACY-ENHANCED MESSAGE-----\nProc-Type: 2001,MIC-CLEAR\n\n");
+    buf_printf(b, "<SEC-DOCUMENT>0000950123-24-%06u.txt : 20240215\n", acc);
+    buf_printf(b, "<SEC-HEADER>0000950123-24-%06u.hdr.sgml : 20240215\n", acc);
+    buf_puts(b, "<ACCEPTANCE-DATETIME>20240215161532\n");
+    buf_printf(b, "ACCESSION NUMBER:\t\t0000950123-24-%06u\n", acc);
+    buf_puts(b, "CONFORMED SUBMISSION TYPE:\t10-K\nPUBLIC DOCUMENT COUNT:\t\t142\n"
+                "CONFORMED PERIOD OF REPORT:\t20231231\nFILED AS OF DATE:\t\t20240215\n"
+                "DATE AS OF CHANGE:\t\t20240215\n\n");
+    for (int f = 0; f < filers; f++) {
+        buf_puts(b, "FILER:\n\n\tCOMPANY DATA:\t\n");
+        buf_printf(b, "\t\tCOMPANY CONFORMED NAME:\t\t\tEXAMPLE HOLDINGS %d INC\n", f);
+        buf_printf(b, "\t\tCENTRAL INDEX KEY:\t\t\t%010u\n", (unsigned)(rng_next(s) % 2000000));
+        buf_puts(b, "\t\tSTANDARD INDUSTRIAL CLASSIFICATION:\tSERVICES-PREPACKAGED SOFTWARE [7372]\n"
+                    "\t\tORGANIZATION NAME:           \tOffice of Technology\n"
+                    "\t\tIRS NUMBER:\t\t\t\t941234567\n\t\tSTATE OF INCORPORATION:\t\t\tDE\n"
+                    "\t\tFISCAL YEAR END:\t\t\t1231\n\n\tFILING VALUES:\n\t\tFORM TYPE:\t\t10-K\n"
+                    "\t\tSEC ACT:\t\t1934 Act\n");
+        buf_printf(b, "\t\tSEC FILE NUMBER:\t001-%05u\n", (unsigned)(rng_next(s) % 100000));
+        buf_printf(b, "\t\tFILM NUMBER:\t\t24%07u\n\n", (unsigned)(rng_next(s) % 10000000));
+        buf_puts(b, "\tBUSINESS ADDRESS:\t\n\t\tSTREET 1:\t\t1 MARKET STREET\n\t\tSTREET 2:\t\tSUITE 100\n"
+                    "\t\tCITY:\t\t\tSAN FRANCISCO\n\t\tSTATE:\t\t\tCA\n\t\tZIP:\t\t\t94105\n"
+                    "\t\tBUSINESS PHONE:\t\t4155550100\n\n\tMAIL ADDRESS:\t\n"
+                    "\t\tSTREET 1:\t\t1 MARKET STREET\n\t\tCITY:\t\t\tSAN FRANCISCO\n\t\tSTATE:\t\t\tCA\n"
+                    "\t\tZIP:\t\t\t94105\n\n\tFORMER COMPANY:\t\n\t\tFORMER CONFORMED NAME:\tEXAMPLE CORP\n"
+                    "\t\tDATE OF NAME CHANGE:\t20010301\n");
+    }
+    buf_puts(b, "</SEC-HEADER>\n");
+}
+
+static void gen_archive_header(gen_buf *b, uint64_t *s, int series) {
+    buf_printf(b, "<SUBMISSION>\n<ACCESSION-NUMBER>0001234567-24-%06u\n<TYPE>N-CSR\n",
+               (unsigned)(rng_next(s) % 1000000));
+    buf_puts(b, "<PUBLIC-DOCUMENT-COUNT>12\n<PERIOD>20231231\n<FILING-DATE>20240215\n"
+                "<FILER>\n<COMPANY-DATA>\n<CONFORMED-NAME>EXAMPLE FUND TRUST\n<CIK>0000111111\n"
+                "<STATE-OF-INCORPORATION>MA\n<FISCAL-YEAR-END>1231\n</COMPANY-DATA>\n"
+                "<FILING-VALUES>\n<FORM-TYPE>N-CSR\n<ACT>40\n<FILE-NUMBER>811-01234\n</FILING-VALUES>\n"
+                "<BUSINESS-ADDRESS>\n<STREET1>100 FEDERAL ST\n<CITY>BOSTON\n<STATE>MA\n<ZIP>02110\n"
+                "</BUSINESS-ADDRESS>\n</FILER>\n<SERIES-AND-CLASSES-CONTRACTS-DATA>\n"
+                "<EXISTING-SERIES-AND-CLASSES-CONTRACTS>\n");
+    for (int i = 0; i < series; i++) {
+        buf_printf(b, "<SERIES>\n<OWNER-CIK>0000111111\n<SERIES-ID>S%09d\n<SERIES-NAME>Example Series %d\n",
+                   i, i);
+        for (int c = 0; c < 3; c++) {
+            buf_printf(b, "<CLASS-CONTRACT>\n<CLASS-CONTRACT-ID>C%09d\n<CLASS-CONTRACT-NAME>Class %c\n"
+                          "<CLASS-CONTRACT-TICKER-SYMBOL>EX%c%dX\n</CLASS-CONTRACT>\n",
+                       i * 3 + c, "AIC"[c], "AIC"[c], i % 10);
+        }
+        buf_puts(b, "</SERIES>\n");
+    }
+    buf_puts(b, "</EXISTING-SERIES-AND-CLASSES-CONTRACTS>\n</SERIES-AND-CLASSES-CONTRACTS-DATA>\n");
+}
+
+// ---------------------------------------------------------------------------
+// Document bodies
+// ---------------------------------------------------------------------------
+static const char *const HTML_MARKUP[] = {
+    "<tr>", "</tr>", "<td style=\"width:10%;text-align:right\">", "</td>", "<p>", "</p>",
+    "<span style=\"font-family:Times New Roman\">", "</span>", "<TD>", "</TD>", "<TR>",
+    "</TR>", "<FONT SIZE=2>", "</FONT>", "<DIV>", "</DIV>", "<B>", "</B>", "<br>",
+    "<ix:nonFraction name=\"us-gaap:Revenues\" contextRef=\"c-1\">", "</ix:nonFraction>",
+};
+#define HTML_MARKUP_COUNT (sizeof(HTML_MARKUP) / sizeof(HTML_MARKUP[0]))
+
+static void gen_html(gen_buf *b, uint64_t *s, size_t size) {
+    size_t end = b->len + size;
+    buf_puts(b, "<HTML>\n<HEAD><TITLE>Annual Report</TITLE></HEAD>\n<BODY>\n<table>\n");
+    while (b->len < end) {
+        buf_puts(b, HTML_MARKUP[rng_next(s) % HTML_MARKUP_COUNT]);
+        switch (rng_next(s) % 4) {
+        case 0: buf_printf(b, "%u,%03u", (unsigned)(rng_next(s) % 1000), (unsigned)(rng_next(s) % 1000)); break;
+        case 1: buf_puts(b, "Total revenues"); break;
+        case 2: buf_puts(b, "&#160;"); break;
+        default: break;
+        }
+        if (rng_next(s) % 6 == 0) buf_puts(b, "\n");
+    }
+    buf_puts(b, "\n</table>\n</BODY>\n</HTML>\n");
+}
+
+static void gen_xbrl(gen_buf *b, uint64_t *s, size_t size) {
+    size_t end = b->len + size;
+    buf_puts(b, "<XBRL>\n<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<xbrli:xbrl>\n");
+    while (b->len < end) {
+        buf_printf(b, "<us-gaap:Revenues contextRef=\"c-%u\" unitRef=\"usd\" decimals=\"-6\">%u000000"
+                      "</us-gaap:Revenues>\n",
+                   (unsigned)(rng_next(s) % 500), (unsigned)(rng_next(s) % 100000));
+    }
+    buf_puts(b, "</xbrli:xbrl>\n</XBRL>\n");
+}
+
+// SEC uuencoding: 45-byte lines, 0 encoded as ' ', trailing spaces stripped
+static void gen_uuencoded(gen_buf *b, uint64_t *s, const char *name, size_t size) {
+    buf_printf(b, "begin 644 %s\n", name);
+    uint8_t chunk[45];
+    char line[64];
+    size_t done = 0;
+    while (done < size) {
+        size_t n = size - done < 45 ? size - done : 45;
+        // PDF-like: compressed streams with runs of zeros
+        int zeros = rng_next(s) % 8 == 0;
+        for (size_t i = 0; i < n; i++) chunk[i] = zeros ? 0 : (uint8_t)rng_next(s);
+        size_t w = 0;
+        line[w++] = (char)(' ' + n);
+        for (size_t i = 0; i < n; i += 3) {
+            uint32_t v = (uint32_t)chunk[i] << 16;
+            if (i + 1 < n) v |= (uint32_t)chunk[i + 1] << 8;
+            if (i + 2 < n) v |= chunk[i + 2];
+            for (int k = 3; k >= 0; k--) line[w++] = (char)(' ' + ((v >> (6 * k)) & 0x3f));
+        }
+        while (w > 1 && line[w - 1] == ' ') w--;
+        line[w++] = '\n';
+        buf_put(b, line, w);
+        done += n;
+    }
+    buf_puts(b, "`\nend\n");
+}
+
+// ---------------------------------------------------------------------------
+// Submissions
+// ---------------------------------------------------------------------------
+char *gen_submission(uint64_t seed, const gen_params *p, size_t *out_len) {
+    uint64_t s = seed * 0x9E3779B97F4A7C15ull + 1;
+    gen_buf b = {0};
+
+    if (p->archive_header) gen_archive_header(&b, &s, 20 + (int)(rng_next(&s) % 40));
+    else                   gen_sec_header(&b, &s, 1 + (int)(rng_next(&s) % 3));
+
+    for (int d = 0; d < p->doc_count; d++) {
+        // Main document first, then exhibits: HTML, XBRL and graphics/PDFs
+        int kind = d == 0 ? 0 : (int)(rng_next(&s) % 3);
+        static const char *const TYPES[] = { "EX-99.1", "EX-101.INS", "GRAPHIC" };
+        static const char *const EXTS[]  = { "htm", "xml", "pdf" };
+        char name[64];
+        snprintf(name, sizeof(name), "ex%d_%d.%s", d, (int)(seed % 1000), EXTS[kind]);
+        buf_printf(&b, "<DOCUMENT>\n<TYPE>%s\n<SEQUENCE>%d\n<FILENAME>%s\n<DESCRIPTION>%s\n<TEXT>\n",
+                   d == 0 ? "10-K" : TYPES[kind], d + 1, name, d == 0 ? "ANNUAL REPORT" : "EXHIBIT");
+        if (kind == 0)      gen_html(&b, &s, rng_range(&s, p->html_bytes / 2, p->html_bytes * 3 / 2));
+        else if (kind == 1) gen_xbrl(&b, &s, rng_range(&s, p->xbrl_bytes / 2, p->xbrl_bytes * 3 / 2));
+        else                gen_uuencoded(&b, &s, name, rng_range(&s, p->binary_bytes / 2, p->binary_bytes * 3 / 2));
+        buf_puts(&b, "</TEXT>\n</DOCUMENT>\n");
+    }
+    if (!p->archive_header) buf_puts(&b, "</SEC-DOCUMENT>\n");
+
+    if (p->crlf) {
+        size_t lines = 0;
+        for (size_t i = 0; i < b.len; i++) lines += b.data[i] == '\n';
+        char *out = (char *)malloc(b.len + lines);
+        if (!out) {
+            fprintf(stderr, "gen: out of memory\n");
+            exit(1);
+        }
+        size_t w = 0;
+        for (size_t i = 0; i < b.len; i++) {
+            if (b.data[i] == '\n') out[w++] = '\r';
+            out[w++] = b.data[i];
+        }
+        free(b.data);
+        *out_len = w;
+        return out;
+    }
+    *out_len = b.len;
+    return b.data;
+}
+
+void gen_corpus_params(uint64_t seed, size_t index, double scale, gen_params *p) {
+    uint64_t s = (seed + index) * 0xD1B54A32D192ED03ull + 7;
+    p->doc_count      = 3 + (int)(rng_next(&s) % 40);
+    p->html_bytes     = (size_t)(scale * (double)rng_range(&s, 20u << 10, 2u << 20));
+    p->xbrl_bytes     = (size_t)(scale * (double)rng_range(&s, 10u << 10, 512u << 10));
+    p->binary_bytes   = (size_t)(scale * (double)rng_range(&s, 16u << 10, 1u << 20));
+    p->archive_header = rng_next(&s) % 4 == 0;
+    p->crlf           = rng_next(&s) % 8 == 0;
+}
@@ -0,0 +1,31 @@
+#ifndef SGML_BENCH_GEN_H
+#define SGML_BENCH_GEN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ---------------------------------------------------------------------------
+// Deterministic synthetic SEC submissions for benchmarks
+//
+// The same seed and parameters always give the same bytes, so numbers from
+// two builds are comparable. A submission has either a tab-indented
+// <SEC-HEADER> or an archive-style <SUBMISSION> header, then a mix of
+// table-heavy HTML, XBRL and uuencoded PDF/graphic documents. Uuencoded
+// lines follow SEC's variable-length convention (trailing spaces stripped).
+// ---------------------------------------------------------------------------
+typedef struct {
+    int    doc_count;      // documents in the submission
+    size_t html_bytes;     // approximate size of each HTML document
+    size_t xbrl_bytes;     // approximate size of each XBRL document
+    size_t binary_bytes;   // decoded size of each uuencoded document
+    int    archive_header; // 1 = <SUBMISSION> header, 0 = <SEC-HEADER>
+    int    crlf;           // CRLF line endings
+} gen_params;
+
+// Random but realistic parameters for file number index of a corpus
+void  gen_corpus_params(uint64_t seed, size_t index, double scale, gen_params *p);
+
+// malloc'd submission, *out_len bytes
+char *gen_submission(uint64_t seed, const gen_params *p, size_t *out_len);
+
+#endif
@@ -6,21 +6,21 @@
 
 #include "secsgml.h"
 #include "standardize_submission_metadata.h"
+#include "sgml_output.h"
+#include "sgml_pack.h"
+#include "sgml_header.h"
+#include "sgml_index.h"
+#include "sgml_thread.h"
+#include "simd.h"
 
 #ifdef _WIN32
-#include <direct.h>
-static int make_dir(const char *path) {
-    if (_mkdir(path) == 0) return 0;
-    if (errno == EEXIST) return 0;
-    return -1;
-}
+#include <windows.h>
 #else
 #include <sys/stat.h>
-static int make_dir(const char *path) {
-    if (mkdir(path, 0755) == 0) return 0;
-    if (errno == EEXIST) return 0;
-    return -1;
-}
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
 #endif
 
 static uint8_t *load_file(const char *path, size_t *out_len) {
@@ -37,9 +37,108 @@ static uint8_t *load_file(const char *path, size_t *out_len) {
     return buf;
 }
 
+// ---------------------------------------------------------------------------
+// Input -- read-only file mapping, falls back to load_file
+//
+// Parsed spans point straight into the input, so with a mapping plain-text
+// documents go from page cache to the output files without being copied.
+// ---------------------------------------------------------------------------
+typedef struct {
+    uint8_t *data;
+    size_t   len;
+    int      mapped;    // 1 = file mapping, 0 = malloc'd by load_file
+#ifdef _WIN32
+    HANDLE   file;
+    HANDLE   mapping;
+#endif
+} input_file;
+
+#ifdef _WIN32
+static int map_file(const char *path, input_file *in, int hugepages) {
+    (void)hugepages;
+    memset(in, 0, sizeof(*in));
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) return -1;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return -1;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping) {
+        CloseHandle(file);
+        return -1;
+    }
+    void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return -1;
+    }
+    in->data    = (uint8_t *)data;
+    in->len     = (size_t)size.QuadPart;
+    in->mapped  = 1;
+    in->file    = file;
+    in->mapping = mapping;
+    return 0;
+}
+
+static void unmap_file(input_file *in) {
+    UnmapViewOfFile(in->data);
+    CloseHandle(in->mapping);
+    CloseHandle(in->file);
+}
+#else
+static int map_file(const char *path, input_file *in, int hugepages) {
+    memset(in, 0, sizeof(*in));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return -1;
+    }
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return -1;
+
+    // Hints only -- failures are harmless
+    madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+    if (hugepages) madvise(data, (size_t)st.st_size, MADV_HUGEPAGE);
+#else
+    (void)hugepages;
+#endif
+
+    in->data   = (uint8_t *)data;
+    in->len    = (size_t)st.st_size;
+    in->mapped = 1;
+    return 0;
+}
+
+static void unmap_file(input_file *in) {
+    munmap(in->data, in->len);
+}
+#endif
+
+static int open_input(const char *path, input_file *in, int use_mmap, int hugepages) {
+    if (use_mmap && map_file(path, in, hugepages) == 0) return 0;
+    memset(in, 0, sizeof(*in));
+    in->data = load_file(path, &in->len);
+    return in->data ? 0 : -1;
+}
+
+static void close_input(input_file *in) {
+    if (!in->data) return;
+    if (in->mapped) unmap_file(in);
+    else free(in->data);
+    in->data = NULL;
+    in->len  = 0;
+}
+
 // Timing
 #ifdef _WIN32
-#include <windows.h>
 static double now_ms(void) {
     static LARGE_INTEGER freq = {0};
     LARGE_INTEGER counter;
@@ -58,292 +157,635 @@ static double now_ms(void) {
 }
 #endif
 
-static void write_span(FILE *f, byte_span s) {
-    if (s.ptr && s.len > 0) {
-        fwrite(s.ptr, 1, s.len, f);
+// ---------------------------------------------------------------------------
+// Per-file pipeline -- shared by single-file and batch mode
+// ---------------------------------------------------------------------------
+typedef struct {
+    int use_mmap;
+    int hugepages;
+    sgml_parse_options parse;
+    sgml_output_options output;
+    int pack;   // write one pack file per submission instead of a directory
+    int header_only;  // read up to the first <DOCUMENT>, write only the JSON
+    int index;        // write the document index sidecar instead of the documents
+} load_options;
+
+typedef struct {
+    double load;
+    double parse;        // header and documents, one pass
+    double standardize;
+    double write;
+} stage_times;
+
+// Everything parsed from one file lives in the worker's arena. Its blocks are
+// kept between files, so a worker stops allocating once it has seen its
+// largest submission, and dropping a file's results is one reset.
+typedef struct {
+    sgml_arena                       arena;
+    sgml_allocator                   alloc;
+    sgml_parse_result                r;
+    submission_metadata              sub;
+    standardized_submission_metadata std;
+    sgml_header                      hdr;  // --header-only
+    sgml_sidecar                     side; // --index, --get
+    sgml_parse_stats                 stats;
+    stage_times                      t;
+    size_t                           files;
+    size_t                           failed;
+    uint64_t                         bytes;
+} worker_state;
+
+static int write_whole_file(const char *path, const void *data, size_t len) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return -1;
+    int ok = fwrite(data, 1, len, f) == len;
+    if (fclose(f) != 0) ok = 0;
+    return ok ? 0 : -1;
+}
+
+// --header-only: positioned reads up to the first <DOCUMENT>, then the same
+// standardized submission_metadata.json, written to output_path
+static int process_header(worker_state *ws, const char *input_path, const char *output_path,
+                          const load_options *lo) {
+    if (!ws->alloc.alloc) {
+        sgml_arena_init(&ws->arena, 0);
+        ws->alloc = sgml_arena_allocator(&ws->arena);
+    }
+    sgml_arena_reset(&ws->arena);
+    memset(&ws->hdr.meta, 0, sizeof(ws->hdr.meta));
+    memset(&ws->std, 0, sizeof(ws->std));
+    ws->hdr.meta.alloc = ws->alloc;
+    ws->std.alloc      = ws->alloc;
+
+    double t0 = now_ms();
+    if (sgml_read_header(input_path, &ws->hdr) != 0) {
+        fprintf(stderr, "Failed to read header: %s\n", input_path);
+        ws->failed++;
+        return -1;
     }
+    double t1 = now_ms();
+    standardize_submission_metadata_into(&ws->std, &ws->hdr.meta);
+    double t2 = now_ms();
+    size_t json_len = 0;
+    char *json = sgml_format_submission_json_ex(&ws->std, &lo->output, &json_len);
+    int w = json ? write_whole_file(output_path, json, json_len) : -1;
+    free(json);
+    if (w != 0) fprintf(stderr, "Failed to write %s\n", output_path);
+    double t3 = now_ms();
+
+    ws->bytes         += ws->hdr.bytes_read;
+    ws->t.load        += t1 - t0;  // read and header parse: they share one pass
+    ws->t.standardize += t2 - t1;
+    ws->t.write       += t3 - t2;
+    ws->files++;
+    if (w != 0) ws->failed++;
+    return w;
 }
 
-static int key_eq(byte_span a, byte_span b) {
-    if (a.len != b.len) return 0;
-    if (a.len == 0) return 1;
-    return memcmp(a.ptr, b.ptr, a.len) == 0;
+// --index: the sidecar sgml_index_cache_get would build, written to
+// output_path. The file is opened once; identity and indexed bytes both
+// come from that handle, so a file replaced mid-way can't pair one file's
+// identity with another's offsets.
+static int process_index(worker_state *ws, const char *input_path, const char *output_path) {
+    sgml_file f;
+    double t0 = now_ms();
+    if (sgml_file_open(&f, input_path) != 0) {
+        fprintf(stderr, "Failed to load input: %s\n", input_path);
+        ws->failed++;
+        return -1;
+    }
+    double t1 = now_ms();
+    // Fails on a read error, an unidentifiable file or OOM: a partial index
+    // or a zero identity must not be written, the cache would trust it
+    int w = sgml_index_build(&ws->side, &f, input_path, &ws->stats);
+    double t2 = now_ms();
+    if (w != 0) {
+        fprintf(stderr, "Failed to index %s\n", input_path);
+    } else {
+        w = sgml_index_write(output_path, &ws->side);
+        if (w != 0) fprintf(stderr, "Failed to write index: %s\n", output_path);
+    }
+    double t3 = now_ms();
+
+    ws->bytes += f.size;
+    sgml_file_close(&f);
+
+    ws->t.load  += t1 - t0;
+    ws->t.parse += t2 - t1;
+    ws->t.write += t3 - t2;
+    ws->files++;
+    if (w != 0) ws->failed++;
+    return w;
 }
 
-static void write_json_string(FILE *f, byte_span s) {
-    fputc('"', f);
-    for (size_t i = 0; i < s.len; i++) {
-        unsigned char c = s.ptr[i];
-        if (c == '"' || c == '\\' || c < 0x20 || c >= 0x80) {
-            fprintf(f, "\\u%04X", (unsigned)c);
-        } else {
-            fputc((int)c, f);
-        }
+static int process_file(worker_state *ws, const char *input_path, const char *output_dir,
+                        const load_options *lo, int *mapped) {
+    if (lo->header_only) return process_header(ws, input_path, output_dir, lo);
+    if (lo->index) return process_index(ws, input_path, output_dir);
+    input_file in;
+    double t0 = now_ms();
+    if (open_input(input_path, &in, lo->use_mmap, lo->hugepages) != 0) {
+        fprintf(stderr, "Failed to load input: %s\n", input_path);
+        ws->failed++;
+        return -1;
     }
-    fputc('"', f);
+    double t1 = now_ms();
+    if (!ws->alloc.alloc) {
+        sgml_arena_init(&ws->arena, 0);
+        ws->alloc = sgml_arena_allocator(&ws->arena);
+    }
+    sgml_arena_reset(&ws->arena);
+    memset(&ws->r, 0, sizeof(ws->r));
+    memset(&ws->sub, 0, sizeof(ws->sub));
+    memset(&ws->std, 0, sizeof(ws->std));
+    ws->sub.alloc = ws->alloc;
+    ws->std.alloc = ws->alloc;
+    sgml_parse_options po = lo->parse;
+    po.allocator = &ws->alloc;
+
+    parse_submission_into(&ws->r, &ws->sub, in.data, in.len, &po, &ws->stats);
+    double t2 = now_ms();
+    standardize_submission_metadata_into(&ws->std, &ws->sub);
+    double t3 = now_ms();
+    int w = lo->pack ? sgml_write_pack_ex(output_dir, &ws->r, &ws->std, &lo->output)
+                     : sgml_write_outputs_ex(output_dir, &ws->r, &ws->std, &lo->output);
+    if (w != 0 && lo->pack) fprintf(stderr, "Failed to write pack: %s\n", output_dir);
+    double t4 = now_ms();
+
+    if (mapped) *mapped = in.mapped;
+    ws->bytes += in.len;
+    close_input(&in);
+
+    ws->t.load        += t1 - t0;
+    ws->t.parse       += t2 - t1;
+    ws->t.standardize += t3 - t2;
+    ws->t.write       += t4 - t3;
+    ws->files++;
+    if (w != 0) ws->failed++;
+    return w;
+}
+
+static void worker_state_free(worker_state *ws) {
+    sgml_header_free(&ws->hdr);  // events are in the arena: free before it
+    sgml_sidecar_free(&ws->side);
+    if (ws->alloc.alloc) sgml_arena_free(&ws->arena);
 }
 
-static size_t find_section_end(const submission_event *events, size_t count, size_t start_idx) {
-    int depth = events[start_idx].depth;
-    for (size_t i = start_idx + 1; i < count; i++) {
-        if (events[i].type == SUB_EVENT_SECTION_END && events[i].depth == depth) {
-            return i;
+// --get: one document by name through the index cache, without parsing the
+// submission when its sidecar is current
+static int run_get(const char *input_path, const char *name, const char *cache_dir,
+                   const char *output_path) {
+    sgml_sidecar side = {0};
+    sgml_file f;
+    int hit = 0;
+    double t0 = now_ms();
+    if (sgml_index_cache_get(cache_dir, input_path, &side, &f, &hit) != 0) {
+        fprintf(stderr, "Failed to index input: %s\n", input_path);
+        sgml_sidecar_free(&side);
+        return 1;
+    }
+    double t1 = now_ms();
+    const sgml_index_entry *e = sgml_index_find(&side.index, name, strlen(name));
+    int rc = 1;
+    if (!e) {
+        fprintf(stderr, "No document with TYPE or FILENAME %s in %s\n", name, input_path);
+    } else {
+        size_t cap = sgml_index_document_size(e), n = 0;
+        uint8_t *out = (uint8_t *)malloc(cap ? cap : 1);
+        if (out && sgml_index_read_document(&f, e, out, cap, &n) == 0) {
+            double t2 = now_ms();
+            rc = write_whole_file(output_path, out, n) == 0 ? 0 : 1;
+            if (rc != 0) fprintf(stderr, "Failed to write %s\n", output_path);
+            double t3 = now_ms();
+            fprintf(stderr, "Timing (ms):\n");
+            fprintf(stderr, "  index (%s):      %.3f\n", hit ? "hit " : "miss", t1 - t0);
+            fprintf(stderr, "  read_document:     %.3f (%zu bytes)\n", t2 - t1, n);
+            fprintf(stderr, "  write:             %.3f\n", t3 - t2);
+        } else {
+            fprintf(stderr, "Failed to read %s from %s\n", name, input_path);
         }
+        free(out);
     }
-    return count;
+    sgml_file_close(&f);
+    sgml_sidecar_free(&side);
+    return rc;
+}
+
+// parse_sgml breakdown, only collected with -DSECSGML_INSTRUMENT
+static void print_parse_counters(const sgml_parse_stats *s) {
+#ifdef SECSGML_INSTRUMENT
+    const sgml_stage_times *t = &s->time;
+    fprintf(stderr, "parse_sgml stages (ms):\n");
+    fprintf(stderr, "  tag_scan:          %.3f\n", (double)t->tag_scan / 1e6);
+    fprintf(stderr, "  uu_bounds:         %.3f\n", (double)t->uu_bounds / 1e6);
+    fprintf(stderr, "  uu_size:           %.3f\n", (double)t->uu_size / 1e6);
+    fprintf(stderr, "  decode:            %.3f\n", (double)t->decode / 1e6);
+    fprintf(stderr, "  strip_wrappers:    %.3f\n", (double)t->strip / 1e6);
+    fprintf(stderr, "  grow (%zu reallocs): %.3f\n", (size_t)s->grow_count, (double)t->grow / 1e6);
+    fprintf(stderr, "Document bytes:\n");
+    fprintf(stderr, "  uuencoded:         %llu (%llu decoded)\n",
+            (unsigned long long)s->uuencoded_bytes, (unsigned long long)s->decoded_bytes);
+    fprintf(stderr, "  plain:             %llu\n", (unsigned long long)s->plain_bytes);
+    fprintf(stderr, "  largest document:  %llu\n", (unsigned long long)s->largest_doc);
+#else
+    (void)s;
+#endif
 }
 
+// ---------------------------------------------------------------------------
+// Batch mode -- job list, per-worker deques with stealing
+// ---------------------------------------------------------------------------
 typedef struct {
-    byte_span key;
-    submission_event_type type;
-    size_t idx;
-    size_t end_idx;
-} json_member;
-
-static void write_object_range(FILE *f, const submission_event *events, size_t start_idx, size_t end_idx, int depth) {
-    json_member *members = NULL;
-    size_t member_count = 0;
-
-    byte_span *uniq_keys = NULL;
-    size_t *uniq_counts = NULL;
-    size_t uniq_count = 0;
-
-    for (size_t i = start_idx; i < end_idx; i++) {
-        if (events[i].depth != depth + 1) continue;
-        if (events[i].type == SUB_EVENT_KEYVAL) {
-            json_member *new_members = (json_member *)realloc(members, (member_count + 1) * sizeof(json_member));
-            if (!new_members) break;
-            members = new_members;
-            members[member_count++] = (json_member){ events[i].key, events[i].type, i, i };
-        } else if (events[i].type == SUB_EVENT_SECTION_START) {
-            size_t end = find_section_end(events, end_idx, i);
-            json_member *new_members = (json_member *)realloc(members, (member_count + 1) * sizeof(json_member));
-            if (!new_members) break;
-            members = new_members;
-            members[member_count++] = (json_member){ events[i].key, events[i].type, i, end };
-            i = end;
-        }
+    char  **paths;
+    size_t  count;
+    size_t  cap;
+} path_list;
+
+static int path_list_push(path_list *l, const char *path, size_t len) {
+    if (l->count == l->cap) {
+        size_t new_cap = l->cap ? l->cap * 2 : 256;
+        char **tmp = (char **)realloc(l->paths, new_cap * sizeof(char *));
+        if (!tmp) return 0;
+        l->paths = tmp;
+        l->cap   = new_cap;
     }
+    char *copy = (char *)malloc(len + 1);
+    if (!copy) return 0;
+    memcpy(copy, path, len);
+    copy[len] = '\0';
+    l->paths[l->count++] = copy;
+    return 1;
+}
 
-    for (size_t i = 0; i < member_count; i++) {
-        int found = 0;
-        for (size_t k = 0; k < uniq_count; k++) {
-            if (key_eq(uniq_keys[k], members[i].key)) {
-                uniq_counts[k]++;
-                found = 1;
-                break;
-            }
-        }
-        if (!found) {
-            byte_span *nk = (byte_span *)realloc(uniq_keys, (uniq_count + 1) * sizeof(byte_span));
-            size_t *nc = (size_t *)realloc(uniq_counts, (uniq_count + 1) * sizeof(size_t));
-            if (!nk || !nc) {
-                free(nk);
-                free(nc);
-                break;
-            }
-            uniq_keys = nk;
-            uniq_counts = nc;
-            uniq_keys[uniq_count] = members[i].key;
-            uniq_counts[uniq_count] = 1;
-            uniq_count++;
+static void path_list_free(path_list *l) {
+    for (size_t i = 0; i < l->count; i++) free(l->paths[i]);
+    free(l->paths);
+    l->paths = NULL;
+    l->count = 0;
+    l->cap   = 0;
+}
+
+// One path per line; blank lines and lines starting with '#' are skipped
+static int read_manifest(const char *path, path_list *l) {
+    size_t len = 0;
+    uint8_t *buf = load_file(path, &len);
+    if (!buf) return -1;
+    size_t i = 0;
+    while (i < len) {
+        size_t j = i;
+        while (j < len && buf[j] != '\n' && buf[j] != '\r') j++;
+        size_t s = i, e = j;
+        while (s < e && (buf[s] == ' ' || buf[s] == '\t')) s++;
+        while (e > s && (buf[e-1] == ' ' || buf[e-1] == '\t')) e--;
+        if (e > s && buf[s] != '#') {
+            if (!path_list_push(l, (const char *)buf + s, e - s)) { free(buf); return -1; }
         }
+        while (j < len && (buf[j] == '\n' || buf[j] == '\r')) j++;
+        i = j;
     }
+    free(buf);
+    return 0;
+}
 
-    int *emitted = (int *)calloc(uniq_count, sizeof(int));
+#ifdef _WIN32
+static int is_directory(const char *path) {
+    DWORD attr = GetFileAttributesA(path);
+    return attr != INVALID_FILE_ATTRIBUTES && (attr & FILE_ATTRIBUTE_DIRECTORY);
+}
+
+static int list_directory(const char *dir, path_list *l) {
+    char pattern[1024];
+    snprintf(pattern, sizeof(pattern), "%s" PATH_SEP "*", dir);
+    WIN32_FIND_DATAA fd;
+    HANDLE h = FindFirstFileA(pattern, &fd);
+    if (h == INVALID_HANDLE_VALUE) return -1;
+    do {
+        if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+        char full[1024];
+        int n = snprintf(full, sizeof(full), "%s" PATH_SEP "%s", dir, fd.cFileName);
+        if (n <= 0 || (size_t)n >= sizeof(full)) continue;
+        if (!path_list_push(l, full, (size_t)n)) { FindClose(h); return -1; }
+    } while (FindNextFileA(h, &fd));
+    FindClose(h);
+    return 0;
+}
+#else
+static int is_directory(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+}
 
-    fputc('{', f);
-    int first = 1;
+static int list_directory(const char *dir, path_list *l) {
+    DIR *d = opendir(dir);
+    if (!d) return -1;
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        if (e->d_name[0] == '.') continue;
+        char full[1024];
+        int n = snprintf(full, sizeof(full), "%s" PATH_SEP "%s", dir, e->d_name);
+        if (n <= 0 || (size_t)n >= sizeof(full)) continue;
+        struct stat st;
+        if (stat(full, &st) != 0 || !S_ISREG(st.st_mode)) continue;
+        if (!path_list_push(l, full, (size_t)n)) { closedir(d); return -1; }
+    }
+    closedir(d);
+    return 0;
+}
+#endif
 
-    for (size_t i = 0; i < member_count; i++) {
-        size_t key_idx = 0;
-        for (; key_idx < uniq_count; key_idx++) {
-            if (key_eq(uniq_keys[key_idx], members[i].key)) break;
-        }
-        if (key_idx >= uniq_count) continue;
-        if (uniq_counts[key_idx] > 1 && emitted[key_idx]) continue;
-
-        if (!first) fputc(',', f);
-        first = 0;
-
-        write_json_string(f, members[i].key);
-        fputc(':', f);
-
-        if (uniq_counts[key_idx] > 1) {
-            fputc('[', f);
-            int first_arr = 1;
-            for (size_t j = 0; j < member_count; j++) {
-                if (!key_eq(members[j].key, members[i].key)) continue;
-                if (!first_arr) fputc(',', f);
-                first_arr = 0;
-                if (members[j].type == SUB_EVENT_KEYVAL) {
-                    write_json_string(f, events[members[j].idx].value);
-                } else {
-                    write_object_range(f, events, members[j].idx + 1, members[j].end_idx, depth + 1);
-                }
-            }
-            fputc(']', f);
-            emitted[key_idx] = 1;
-        } else {
-            if (members[i].type == SUB_EVENT_KEYVAL) {
-                write_json_string(f, events[members[i].idx].value);
-            } else {
-                write_object_range(f, events, members[i].idx + 1, members[i].end_idx, depth + 1);
-            }
-        }
+// <output_root>/<input file name without extension>
+static void batch_output_dir(char *dst, size_t dst_cap, const char *root, const char *input) {
+    const char *base = input;
+    for (const char *c = input; *c; c++) {
+        if (*c == '/' || *c == '\\') base = c + 1;
     }
+    const char *dot = strrchr(base, '.');
+    size_t stem_len = (dot && dot != base) ? (size_t)(dot - base) : strlen(base);
+    snprintf(dst, dst_cap, "%s" PATH_SEP "%.*s", root, (int)stem_len, base);
+}
 
-    fputc('}', f);
+// Each worker owns a contiguous slice of the job list and takes from its
+// front. An idle worker steals from the back of another worker's slice, so
+// one huge filing doesn't leave the rest of its slice waiting.
+typedef struct {
+    sgml_mutex lock;
+    size_t     head;
+    size_t     tail;
+} work_deque;
+
+static int deque_pop(work_deque *d, size_t *job) {
+    int ok = 0;
+    sgml_mutex_lock(&d->lock);
+    if (d->head < d->tail) { *job = d->head++; ok = 1; }
+    sgml_mutex_unlock(&d->lock);
+    return ok;
+}
 
-    free(emitted);
-    free(uniq_keys);
-    free(uniq_counts);
-    free(members);
+static int deque_steal(work_deque *d, size_t *job) {
+    int ok = 0;
+    sgml_mutex_lock(&d->lock);
+    if (d->head < d->tail) { *job = --d->tail; ok = 1; }
+    sgml_mutex_unlock(&d->lock);
+    return ok;
 }
 
-static void write_csv_cell(FILE *f, byte_span s) {
-    int needs_quotes = 0;
-    for (size_t i = 0; i < s.len; i++) {
-        unsigned char c = s.ptr[i];
-        if (c == '"' || c == ',' || c == '\n' || c == '\r') {
-            needs_quotes = 1;
-            break;
-        }
-    }
-    if (!needs_quotes) {
-        write_span(f, s);
-        return;
-    }
-    fputc('"', f);
-    for (size_t i = 0; i < s.len; i++) {
-        unsigned char c = s.ptr[i];
-        if (c == '"') fputc('"', f);
-        fputc((int)c, f);
+typedef struct {
+    const path_list    *jobs;
+    const char         *output_root;
+    const load_options *lo;
+    work_deque         *deques;
+    int                 nworkers;
+} batch_ctx;
+
+typedef struct {
+    batch_ctx   *ctx;
+    int          id;
+    worker_state ws;
+} batch_worker;
+
+static int next_job(batch_ctx *ctx, int id, size_t *job) {
+    if (deque_pop(&ctx->deques[id], job)) return 1;
+    for (int k = 1; k < ctx->nworkers; k++) {
+        if (deque_steal(&ctx->deques[(id + k) % ctx->nworkers], job)) return 1;
     }
-    fputc('"', f);
+    return 0;
 }
 
-static void sanitize_filename(char *dst, size_t dst_cap, byte_span name, size_t index) {
-    if (!dst || dst_cap == 0) return;
-    size_t pos = 0;
-    if (name.ptr && name.len > 0) {
-        for (size_t i = 0; i < name.len && pos + 1 < dst_cap; i++) {
-            unsigned char c = name.ptr[i];
-            if (c == '\\' || c == '/' || c == ':' || c == '*' || c == '?' ||
-                c == '"'  || c == '<' || c == '>' || c == '|') {
-                c = '_';
-            }
-            dst[pos++] = (char)c;
+static SGML_THREAD_FUNC(batch_worker_main, arg) {
+    batch_worker *bw = (batch_worker *)arg;
+    batch_ctx *ctx = bw->ctx;
+    size_t job;
+    while (next_job(ctx, bw->id, &job)) {
+        const char *input = ctx->jobs->paths[job];
+        char out_dir[1024];
+        batch_output_dir(out_dir, sizeof(out_dir), ctx->output_root, input);
+        if (ctx->lo->header_only) {
+            strncat(out_dir, ".json", sizeof(out_dir) - strlen(out_dir) - 1);
+        } else if (ctx->lo->index) {
+            strncat(out_dir, ".sgmlidx", sizeof(out_dir) - strlen(out_dir) - 1);
+        } else if (ctx->lo->pack) {
+            strncat(out_dir, ".sgmlpack", sizeof(out_dir) - strlen(out_dir) - 1);
         }
-        dst[pos] = '\0';
-        if (pos > 0) return;
+        process_file(&bw->ws, input, out_dir, ctx->lo, NULL);
     }
-    snprintf(dst, dst_cap, "doc_%zu.bin", index);
+    return SGML_THREAD_RETURN;
 }
 
-static int write_outputs(const char *out_dir, const sgml_parse_result *r, const standardized_submission_metadata *m) {
-    if (make_dir(out_dir) != 0) {
-        fprintf(stderr, "Failed to create output dir: %s\n", out_dir);
-        return -1;
+static int run_batch(const char *source, const char *output_root, int nthreads, const load_options *lo) {
+    path_list jobs = {0};
+    int listed = is_directory(source) ? list_directory(source, &jobs) : read_manifest(source, &jobs);
+    if (listed != 0) {
+        fprintf(stderr, "Failed to read batch source: %s\n", source);
+        path_list_free(&jobs);
+        return 1;
     }
-
-    if (m && m->count > 0) {
-        char sub_path[1024];
-        snprintf(sub_path, sizeof(sub_path), "%s\\submission_metadata.json", out_dir);
-        FILE *sub = fopen(sub_path, "wb");
-        if (sub) {
-            write_object_range(sub, m->events, 0, m->count, -1);
-            fputc('\n', sub);
-            fclose(sub);
-        } else {
-            fprintf(stderr, "Failed to open submission metadata file: %s\n", sub_path);
-        }
+    if (sgml_make_dir(output_root) != 0) {
+        fprintf(stderr, "Failed to create output dir: %s\n", output_root);
+        path_list_free(&jobs);
+        return 1;
     }
 
-    char meta_path[1024];
-    snprintf(meta_path, sizeof(meta_path), "%s\\document_metadata.csv", out_dir);
-    FILE *meta = fopen(meta_path, "wb");
-    if (!meta) {
-        fprintf(stderr, "Failed to open metadata file: %s\n", meta_path);
-        return -1;
+    if (nthreads <= 0) nthreads = sgml_cpu_count();
+    if ((size_t)nthreads > jobs.count) nthreads = jobs.count ? (int)jobs.count : 1;
+
+    // Workers already fill the cores; don't also fan out inside each file
+    load_options worker_lo = *lo;
+    if (nthreads > 1) {
+        worker_lo.parse.decode_threads = 1;
+        worker_lo.output.threads       = 1;
+    }
+    lo = &worker_lo;
+
+    work_deque   *deques  = (work_deque *)calloc((size_t)nthreads, sizeof(work_deque));
+    batch_worker *workers = (batch_worker *)calloc((size_t)nthreads, sizeof(batch_worker));
+    sgml_thread  *threads = (sgml_thread *)calloc((size_t)nthreads, sizeof(sgml_thread));
+    if (!deques || !workers || !threads) {
+        fprintf(stderr, "Out of memory\n");
+        free(deques); free(workers); free(threads);
+        path_list_free(&jobs);
+        return 1;
     }
 
-    fputs("TYPE,SEQUENCE,FILENAME,DESCRIPTION\n", meta);
-
-    for (size_t i = 0; i < r->doc_count; i++) {
-        const document *doc = &r->docs[i];
-        write_csv_cell(meta, doc->meta.type);
-        fputc(',', meta);
-        write_csv_cell(meta, doc->meta.sequence);
-        fputc(',', meta);
-        write_csv_cell(meta, doc->meta.filename);
-        fputc(',', meta);
-        write_csv_cell(meta, doc->meta.description);
-        fputc('\n', meta);
-
-        char fname[512];
-        sanitize_filename(fname, sizeof(fname), doc->meta.filename, i + 1);
-        char out_path[1200];
-        snprintf(out_path, sizeof(out_path), "%s\\%s", out_dir, fname);
-
-        FILE *out = fopen(out_path, "wb");
-        if (!out) {
-            fprintf(stderr, "Failed to write document: %s\n", out_path);
-            continue;
-        }
+    batch_ctx ctx = { &jobs, output_root, lo, deques, nthreads };
+    for (int i = 0; i < nthreads; i++) {
+        sgml_mutex_init(&deques[i].lock);
+        deques[i].head = jobs.count * (size_t)i / (size_t)nthreads;
+        deques[i].tail = jobs.count * (size_t)(i + 1) / (size_t)nthreads;
+        workers[i].ctx = &ctx;
+        workers[i].id  = i;
+    }
 
-        // Use decoded buffer if uuencoded, otherwise write raw content
-        if (doc->is_uuencoded && doc->decoded && doc->decoded_len > 0) {
-            fwrite(doc->decoded, 1, doc->decoded_len, out);
-        } else if (!doc->is_uuencoded && doc->content_start && doc->content_len > 0) {
-            fwrite(doc->content_start, 1, doc->content_len, out);
-        }
+    double t0 = now_ms();
+    int started = 0;
+    for (int i = 1; i < nthreads; i++) {
+        if (!sgml_thread_start(&threads[i], batch_worker_main, &workers[i])) break;
+        started = i;
+    }
+    batch_worker_main(&workers[0]);  // calling thread is worker 0
+    for (int i = 1; i <= started; i++) sgml_thread_join(threads[i]);
+    double t1 = now_ms();
 
-        fclose(out);
+    worker_state total = {0};
+    for (int i = 0; i < nthreads; i++) {
+        worker_state *ws = &workers[i].ws;
+        total.files             += ws->files;
+        total.failed            += ws->failed;
+        total.bytes             += ws->bytes;
+        sgml_parse_stats_add(&total.stats, &ws->stats);
+        total.t.load            += ws->t.load;
+        total.t.parse           += ws->t.parse;
+        total.t.standardize     += ws->t.standardize;
+        total.t.write           += ws->t.write;
+        worker_state_free(ws);
+        sgml_mutex_destroy(&deques[i].lock);
     }
 
-    fclose(meta);
-    return 0;
+    double wall_s = (t1 - t0) / 1000.0;
+    fprintf(stderr, "Batch: %zu files (%zu failed), %zu documents (%zu uuencoded, %zu filtered out), "
+                    "%d threads, simd %s\n",
+            total.files, total.failed, total.stats.doc_count, total.stats.uuencoded_count,
+            total.stats.filtered_count, nthreads,
+            sgml_simd_name(sgml_simd_active()));
+    fprintf(stderr, "  wall (ms):         %.3f\n", t1 - t0);
+    fprintf(stderr, "  files/s:           %.1f\n", wall_s > 0 ? (double)total.files / wall_s : 0.0);
+    fprintf(stderr, "  GB/s:              %.3f\n", wall_s > 0 ? (double)total.bytes / 1e9 / wall_s : 0.0);
+    fprintf(stderr, "Stage time summed over workers (ms):\n");
+    fprintf(stderr, "  load:              %.3f\n", total.t.load);
+    fprintf(stderr, "  parse_submission:  %.3f\n", total.t.parse);
+    fprintf(stderr, "  standardize_meta:  %.3f\n", total.t.standardize);
+    fprintf(stderr, "  write_outputs:     %.3f\n", total.t.write);
+    print_parse_counters(&total.stats);
+
+    free(deques);
+    free(workers);
+    free(threads);
+    path_list_free(&jobs);
+    return total.failed == 0 ? 0 : 1;
 }
 
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [options] <input.txt> <output_dir>\n", prog);
+    fprintf(stderr, "       %s [options] --batch <manifest|dir> <output_root>\n", prog);
+    fprintf(stderr, "       %s --get NAME [--index-cache DIR] <input.txt> <output_file>\n", prog);
+    fprintf(stderr, "  --read       load with fread instead of mapping the file\n");
+    fprintf(stderr, "  --hugepages  ask for transparent huge pages on the mapping\n");
+    fprintf(stderr, "  --batch      parse every file in a directory or listed in a manifest\n");
+    fprintf(stderr, "  --threads N  batch worker count (default: all cores)\n");
+    fprintf(stderr, "  --write-threads N  threads writing one submission's documents (default: all cores)\n");
+    fprintf(stderr, "  --type GLOB  keep only documents whose TYPE matches ('*', '?'; repeatable)\n");
+    fprintf(stderr, "  --exclude-type GLOB  drop documents whose TYPE matches (repeatable)\n"
+                    "               (neither filter works with --header-only, --index or --get)\n");
+    fprintf(stderr, "  --utf8-json  keep valid UTF-8 in submission_metadata.json instead of \\u00XX escapes\n");
+    fprintf(stderr, "  --pack       write each submission as one pack file (<output> is the file;\n"
+                    "               <output_root>/<name>.sgmlpack in batch mode)\n");
+    fprintf(stderr, "  --header-only  read only up to the first <DOCUMENT> and write the\n"
+                    "               standardized header JSON (<output> is the file;\n"
+                    "               <output_root>/<name>.json in batch mode)\n");
+    fprintf(stderr, "  --index      write the document index sidecar: offsets, meta and decoded\n"
+                    "               sizes, nothing decoded (<output> is the file;\n"
+                    "               <output_root>/<name>.sgmlidx in batch mode)\n");
+    fprintf(stderr, "  --get NAME   write the first document whose TYPE or FILENAME is NAME to\n"
+                    "               <output>, through the index cache: the submission is only\n"
+                    "               parsed when its sidecar is missing or stale\n");
+    fprintf(stderr, "  --index-cache DIR  keep --get sidecars in DIR (default: <input>.sgmlidx)\n");
+}
+
+#define MAX_TYPE_FILTERS 64
+
 int main(int argc, char **argv) {
-    if (argc < 3) {
-        fprintf(stderr, "Usage: %s <input.txt> <output_dir>\n", argv[0]);
+    load_options lo = { 1, 0, {0}, {0}, 0, 0, 0 };
+    // --type / --exclude-type globs, pointing into argv
+    const char *types[MAX_TYPE_FILTERS];
+    const char *exclude_types[MAX_TYPE_FILTERS];
+    sgml_filter filter = {0};
+    filter.types         = types;
+    filter.exclude_types = exclude_types;
+    int batch    = 0;
+    int nthreads = 0;
+    const char *get_name  = NULL;
+    const char *cache_dir = NULL;
+    const char *positional[2] = {0};
+    int npos = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--read") == 0) {
+            lo.use_mmap = 0;
+        } else if (strcmp(argv[i], "--hugepages") == 0) {
+            lo.hugepages = 1;
+        } else if (strcmp(argv[i], "--pack") == 0) {
+            lo.pack = 1;
+        } else if (strcmp(argv[i], "--header-only") == 0) {
+            lo.header_only = 1;
+        } else if (strcmp(argv[i], "--index") == 0) {
+            lo.index = 1;
+        } else if (strcmp(argv[i], "--get") == 0 && i + 1 < argc) {
+            get_name = argv[++i];
+        } else if (strcmp(argv[i], "--index-cache") == 0 && i + 1 < argc) {
+            cache_dir = argv[++i];
+        } else if ((strcmp(argv[i], "--type") == 0 || strcmp(argv[i], "--exclude-type") == 0) &&
+                   i + 1 < argc) {
+            int exclude = argv[i][2] == 'e';
+            size_t *n = exclude ? &filter.nexclude_types : &filter.ntypes;
+            if (*n == MAX_TYPE_FILTERS) {
+                fprintf(stderr, "At most %d %s options\n", MAX_TYPE_FILTERS, argv[i]);
+                return 1;
+            }
+            (exclude ? exclude_types : types)[(*n)++] = argv[++i];
+            lo.parse.filter = &filter;
+        } else if (strcmp(argv[i], "--batch") == 0) {
+            batch = 1;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            nthreads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--write-threads") == 0 && i + 1 < argc) {
+            lo.output.threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--utf8-json") == 0) {
+            lo.output.utf8 = 1;
+        } else if (argv[i][0] == '-' && argv[i][1] == '-') {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            usage(argv[0]);
+            return 1;
+        } else if (npos < 2) {
+            positional[npos++] = argv[i];
+        }
+    }
+    if (npos < 2) {
+        usage(argv[0]);
         return 1;
     }
 
-    const char *input_path = argv[1];
-    const char *output_dir = argv[2];
-
-    size_t in_len = 0;
-    double t0 = now_ms();
-    uint8_t *buf = load_file(input_path, &in_len);
-    double t1 = now_ms();
-    if (!buf) {
-        fprintf(stderr, "Failed to load input: %s\n", input_path);
+    // These modes never build a filtered document list: the header stops
+    // before the documents, and a sidecar must index every document, since
+    // --get trusts it for any name while the file is unchanged
+    if (lo.parse.filter && (lo.header_only || lo.index || get_name)) {
+        fprintf(stderr, "--type and --exclude-type can't be combined with %s\n",
+                lo.header_only ? "--header-only" : lo.index ? "--index" : "--get");
         return 1;
     }
-    sgml_parse_stats stats = {0};
-    double t2 = now_ms();
-    submission_metadata sub = parse_submission_metadata(buf, in_len);
-    double t3 = now_ms();
-    standardized_submission_metadata std = standardize_submission_metadata(&sub);
-    double t4 = now_ms();
-    sgml_parse_result r = parse_sgml(buf, in_len, &stats);
-    double t5 = now_ms();
-    int w = write_outputs(output_dir, &r, &std);
-
-    free_sgml_parse_result(&r);
-    free_standardized_submission_metadata(&std);
-    free_submission_metadata(&sub);
-    free(buf);
 
-    fprintf(stderr, "Timing (ms):\n");
-    fprintf(stderr, "  load:              %.3f\n", (t1 - t0));
-    fprintf(stderr, "  parse_sub_metadata: %.3f\n", (t3 - t2));
-    fprintf(stderr, "  standardize_meta:  %.3f\n", (t4 - t3));
-    fprintf(stderr, "  parse_sgml:        %.3f\n", (t5 - t4));
-    fprintf(stderr, "  parse_total:       %.3f\n", (t5 - t2));
+    if (get_name) return run_get(positional[0], get_name, cache_dir, positional[1]);
+    if (batch) return run_batch(positional[0], positional[1], nthreads, &lo);
+
+    worker_state ws = {0};
+    int mapped = 0;
+    int w = process_file(&ws, positional[0], positional[1], &lo, &mapped);
+    worker_state_free(&ws);
+    if (ws.files == 0) return 1;
+
+    // With a mapping, page-in cost moves from load into the pass over the
+    // input (parse_submission), so compare load + parse_total.
+    double parse_total = ws.t.parse + ws.t.standardize;
+    fprintf(stderr, "Timing (ms, simd %s):\n", sgml_simd_name(sgml_simd_active()));
+    fprintf(stderr, "  load (%s):       %.3f\n", mapped ? "mmap" : "read", ws.t.load);
+    fprintf(stderr, "  parse_submission:  %.3f\n", ws.t.parse);
+    fprintf(stderr, "  standardize_meta:  %.3f\n", ws.t.standardize);
+    fprintf(stderr, "  parse_total:       %.3f\n", parse_total);
+    fprintf(stderr, "  load+parse:        %.3f\n", ws.t.load + parse_total);
+    fprintf(stderr, "  write_outputs:     %.3f\n", ws.t.write);
+    if (lo.parse.filter) {
+        fprintf(stderr, "Documents: %zu kept, %zu filtered out\n",
+                ws.stats.doc_count, ws.stats.filtered_count);
+    }
+    print_parse_counters(&ws.stats);
 
     return w == 0 ? 0 : 1;
 }
@@ -0,0 +1,387 @@
+#include "scan.h"
+#include "simd.h"
+
+#include <string.h>
+
+#if defined(SGML_X86_DISPATCH)
+#include <immintrin.h>
+#elif defined(SGML_NEON_DISPATCH)
+#include <arm_neon.h>
+#endif
+
+// ---------------------------------------------------------------------------
+// Find '<'
+// ---------------------------------------------------------------------------
+
+// glibc memchr has its own dispatch; used as the scalar tier
+static const uint8_t *find_lt_scalar(const uint8_t *p, const uint8_t *end) {
+    return (const uint8_t *)memchr(p, '<', (size_t)(end - p));
+}
+
+#ifdef SGML_X86_DISPATCH
+SGML_TARGET_SSE2
+static const uint8_t *find_lt_sse2(const uint8_t *p, const uint8_t *end) {
+    __m128i lt = _mm_set1_epi8('<');
+    while (p + 16 <= end) {
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)p), lt));
+        if (mask) return p + __builtin_ctz(mask);
+        p += 16;
+    }
+    while (p < end && *p != '<') p++;
+    return p < end ? p : NULL;
+}
+
+SGML_TARGET_AVX2
+static const uint8_t *find_lt_avx2(const uint8_t *p, const uint8_t *end) {
+    __m256i lt = _mm256_set1_epi8('<');
+    while (p + 32 <= end) {
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)p), lt));
+        if (mask) return p + __builtin_ctz(mask);
+        p += 32;
+    }
+    while (p < end && *p != '<') p++;
+    return p < end ? p : NULL;
+}
+
+SGML_TARGET_AVX512VBMI
+static const uint8_t *find_lt_avx512(const uint8_t *p, const uint8_t *end) {
+    __m512i lt = _mm512_set1_epi8('<');
+    while (p + 64 <= end) {
+        uint64_t mask = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512((const void *)p), lt);
+        if (mask) return p + __builtin_ctzll(mask);
+        p += 64;
+    }
+    while (p < end && *p != '<') p++;
+    return p < end ? p : NULL;
+}
+#endif
+
+#ifdef SGML_NEON_DISPATCH
+static const uint8_t *find_lt_neon(const uint8_t *p, const uint8_t *end) {
+    uint8x16_t lt = vdupq_n_u8('<');
+    while (p + 16 <= end) {
+        uint8x16_t match = vceqq_u8(vld1q_u8(p), lt);
+        // Narrow to 4 bits per byte so the first match is a ctz away
+        uint64_t bits = vget_lane_u64(vreinterpret_u64_u8(
+            vshrn_n_u16(vreinterpretq_u16_u8(match), 4)), 0);
+        if (bits) return p + (__builtin_ctzll(bits) >> 2);
+        p += 16;
+    }
+    while (p < end && *p != '<') p++;
+    return p < end ? p : NULL;
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// Find tag candidates
+//
+// parse_sgml only dispatches on <DOCUMENT>, <DESCRIPTION>, <TEXT>, <TYPE>,
+// <SEQUENCE>, <FILENAME>, </DOCUMENT> and </TEXT>. The vector kernels compare
+// '<' and the next three bytes of a whole block against those prefixes ("<DO",
+// "<DE", "<TE", "<TY", "<SE", "<FI", "</DO", "</TE") and AND the results into
+// a candidate bitmask, so the '<' of HTML/XBRL markup (<TD>, <FONT>, </TR>...)
+// is never visited one at a time. A '<' too close to end to rule out counts
+// as a candidate.
+//
+// Inside <TEXT> only the closing tags matter, so find_close tests just "</DO"
+// and "</TE": one '/' compare rejects nearly every '<' of the body.
+// ---------------------------------------------------------------------------
+static inline int close_candidate(const uint8_t *lt, const uint8_t *end) {
+    if (end - lt < 4) return 1;
+    return lt[1] == '/' && ((lt[2] == 'D' && lt[3] == 'O') || (lt[2] == 'T' && lt[3] == 'E'));
+}
+
+static inline int tag_candidate(const uint8_t *lt, const uint8_t *end) {
+    if (end - lt < 4) return 1;
+    uint8_t c2 = lt[2];
+    switch (lt[1]) {
+    case 'D': return c2 == 'O' || c2 == 'E';
+    case 'T': return c2 == 'E' || c2 == 'Y';
+    case 'S': return c2 == 'E';
+    case 'F': return c2 == 'I';
+    case '/': return close_candidate(lt, end);
+    default:  return 0;
+    }
+}
+
+#define DEFINE_FIND_SCALAR(name, candidate)                                  \
+    static const uint8_t *name(const uint8_t *p, const uint8_t *end) {       \
+        while ((p = find_lt_scalar(p, end)) != NULL) {                       \
+            if (candidate(p, end)) return p;                                 \
+            p++;                                                             \
+        }                                                                    \
+        return NULL;                                                         \
+    }                                                                        \
+    static const uint8_t *name##_tail(const uint8_t *p, const uint8_t *end) { \
+        for (; p < end; p++) {                                               \
+            if (*p == '<' && candidate(p, end)) return p;                    \
+        }                                                                    \
+        return NULL;                                                         \
+    }
+
+DEFINE_FIND_SCALAR(find_tag_scalar, tag_candidate)
+DEFINE_FIND_SCALAR(find_close_scalar, close_candidate)
+
+// The prefix tests are the same for every vector width; each tier defines
+// OR/AND/CMP for its registers.
+#define CLOSE_TEST(b1, b2, b3) \
+    AND(CMP(b1, '/'), OR(AND(CMP(b2, 'D'), CMP(b3, 'O')), AND(CMP(b2, 'T'), CMP(b3, 'E'))))
+
+#define TAG_TEST(b1, b2, b3)                                                     \
+    OR(OR(OR(AND(CMP(b1, 'D'), OR(CMP(b2, 'O'), CMP(b2, 'E'))),                  \
+             AND(CMP(b1, 'T'), OR(CMP(b2, 'E'), CMP(b2, 'Y')))),                 \
+          OR(AND(CMP(b1, 'S'), CMP(b2, 'E')), AND(CMP(b1, 'F'), CMP(b2, 'I')))), \
+       CLOSE_TEST(b1, b2, b3))
+
+#ifdef SGML_X86_DISPATCH
+#define OR(a, b)  _mm_or_si128(a, b)
+#define AND(a, b) _mm_and_si128(a, b)
+#define CMP(v, c) _mm_cmpeq_epi8(v, _mm_set1_epi8(c))
+#define DEFINE_FIND_SSE2(name, TEST, tail)                                   \
+    SGML_TARGET_SSE2                                                         \
+    static const uint8_t *name(const uint8_t *p, const uint8_t *end) {       \
+        const __m128i lt = _mm_set1_epi8('<');                               \
+        while (p + 19 <= end) {                                              \
+            uint32_t mask = (uint32_t)_mm_movemask_epi8(                     \
+                _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)p), lt));    \
+            if (mask) {                                                      \
+                __m128i b1 = _mm_loadu_si128((const __m128i *)(p + 1));      \
+                __m128i b2 = _mm_loadu_si128((const __m128i *)(p + 2));      \
+                __m128i b3 = _mm_loadu_si128((const __m128i *)(p + 3));      \
+                mask &= (uint32_t)_mm_movemask_epi8(TEST(b1, b2, b3));       \
+                if (mask) return p + __builtin_ctz(mask);                    \
+            }                                                                \
+            p += 16;                                                         \
+        }                                                                    \
+        return tail(p, end);                                                 \
+    }
+DEFINE_FIND_SSE2(find_tag_sse2, TAG_TEST, find_tag_scalar_tail)
+DEFINE_FIND_SSE2(find_close_sse2, CLOSE_TEST, find_close_scalar_tail)
+#undef OR
+#undef AND
+#undef CMP
+
+#define OR(a, b)  _mm256_or_si256(a, b)
+#define AND(a, b) _mm256_and_si256(a, b)
+#define CMP(v, c) _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c))
+#define DEFINE_FIND_AVX2(name, TEST, tail)                                   \
+    SGML_TARGET_AVX2                                                         \
+    static const uint8_t *name(const uint8_t *p, const uint8_t *end) {       \
+        const __m256i lt = _mm256_set1_epi8('<');                            \
+        while (p + 35 <= end) {                                              \
+            uint32_t mask = (uint32_t)_mm256_movemask_epi8(                  \
+                _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)p), lt)); \
+            if (mask) {                                                      \
+                __m256i b1 = _mm256_loadu_si256((const __m256i *)(p + 1));   \
+                __m256i b2 = _mm256_loadu_si256((const __m256i *)(p + 2));   \
+                __m256i b3 = _mm256_loadu_si256((const __m256i *)(p + 3));   \
+                mask &= (uint32_t)_mm256_movemask_epi8(TEST(b1, b2, b3));    \
+                if (mask) return p + __builtin_ctz(mask);                    \
+            }                                                                \
+            p += 32;                                                         \
+        }                                                                    \
+        return tail(p, end);                                                 \
+    }
+DEFINE_FIND_AVX2(find_tag_avx2, TAG_TEST, find_tag_scalar_tail)
+DEFINE_FIND_AVX2(find_close_avx2, CLOSE_TEST, find_close_scalar_tail)
+#undef OR
+#undef AND
+#undef CMP
+
+// AVX-512 compares straight into mask registers
+#define OR(a, b)  ((a) | (b))
+#define AND(a, b) ((a) & (b))
+#define CMP(v, c) _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(c))
+#define DEFINE_FIND_AVX512(name, TEST, tail)                                 \
+    SGML_TARGET_AVX512VBMI                                                   \
+    static const uint8_t *name(const uint8_t *p, const uint8_t *end) {       \
+        const __m512i lt = _mm512_set1_epi8('<');                            \
+        while (p + 67 <= end) {                                              \
+            uint64_t mask = _mm512_cmpeq_epi8_mask(                          \
+                _mm512_loadu_si512((const void *)p), lt);                    \
+            if (mask) {                                                      \
+                __m512i b1 = _mm512_loadu_si512((const void *)(p + 1));      \
+                __m512i b2 = _mm512_loadu_si512((const void *)(p + 2));      \
+                __m512i b3 = _mm512_loadu_si512((const void *)(p + 3));      \
+                mask &= TEST(b1, b2, b3);                                    \
+                if (mask) return p + __builtin_ctzll(mask);                  \
+            }                                                                \
+            p += 64;                                                         \
+        }                                                                    \
+        return tail(p, end);                                                 \
+    }
+DEFINE_FIND_AVX512(find_tag_avx512, TAG_TEST, find_tag_scalar_tail)
+DEFINE_FIND_AVX512(find_close_avx512, CLOSE_TEST, find_close_scalar_tail)
+#undef OR
+#undef AND
+#undef CMP
+#endif
+
+#ifdef SGML_NEON_DISPATCH
+#define OR(a, b)  vorrq_u8(a, b)
+#define AND(a, b) vandq_u8(a, b)
+#define CMP(v, c) vceqq_u8(v, vdupq_n_u8(c))
+#define DEFINE_FIND_NEON(name, TEST, tail)                                   \
+    static const uint8_t *name(const uint8_t *p, const uint8_t *end) {       \
+        const uint8x16_t lt = vdupq_n_u8('<');                               \
+        while (p + 19 <= end) {                                              \
+            uint8x16_t b1 = vld1q_u8(p + 1);                                 \
+            uint8x16_t b2 = vld1q_u8(p + 2);                                 \
+            uint8x16_t b3 = vld1q_u8(p + 3);                                 \
+            uint8x16_t match = vandq_u8(vceqq_u8(vld1q_u8(p), lt), TEST(b1, b2, b3)); \
+            uint64_t bits = vget_lane_u64(vreinterpret_u64_u8(               \
+                vshrn_n_u16(vreinterpretq_u16_u8(match), 4)), 0);            \
+            if (bits) return p + (__builtin_ctzll(bits) >> 2);               \
+            p += 16;                                                         \
+        }                                                                    \
+        return tail(p, end);                                                 \
+    }
+DEFINE_FIND_NEON(find_tag_neon, TAG_TEST, find_tag_scalar_tail)
+DEFINE_FIND_NEON(find_close_neon, CLOSE_TEST, find_close_scalar_tail)
+#undef OR
+#undef AND
+#undef CMP
+#endif
+#undef TAG_TEST
+#undef CLOSE_TEST
+
+// ---------------------------------------------------------------------------
+// Find bytes a JSON string can't hold as-is: '"', '\\', control bytes, and
+// bytes >= 0x80 (escaped, or checked as UTF-8 by the caller). As signed bytes
+// the last two are exactly "less than 0x20", so that's one compare.
+// ---------------------------------------------------------------------------
+static inline int json_special(uint8_t c) {
+    return c < 0x20 || c >= 0x80 || c == '"' || c == '\\';
+}
+
+static const uint8_t *find_json_escape_scalar(const uint8_t *p, const uint8_t *end) {
+    for (; p < end; p++) {
+        if (json_special(*p)) return p;
+    }
+    return NULL;
+}
+
+#ifdef SGML_X86_DISPATCH
+SGML_TARGET_SSE2
+static const uint8_t *find_json_escape_sse2(const uint8_t *p, const uint8_t *end) {
+    const __m128i quote = _mm_set1_epi8('"'), bslash = _mm_set1_epi8('\\');
+    const __m128i space = _mm_set1_epi8(0x20);
+    while (p + 16 <= end) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, bslash)),
+                                 _mm_cmplt_epi8(v, space));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(m);
+        if (mask) return p + __builtin_ctz(mask);
+        p += 16;
+    }
+    return find_json_escape_scalar(p, end);
+}
+
+SGML_TARGET_AVX2
+static const uint8_t *find_json_escape_avx2(const uint8_t *p, const uint8_t *end) {
+    const __m256i quote = _mm256_set1_epi8('"'), bslash = _mm256_set1_epi8('\\');
+    const __m256i space = _mm256_set1_epi8(0x20);
+    while (p + 32 <= end) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, bslash)),
+                                    _mm256_cmpgt_epi8(space, v));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(m);
+        if (mask) return p + __builtin_ctz(mask);
+        p += 32;
+    }
+    return find_json_escape_scalar(p, end);
+}
+
+SGML_TARGET_AVX512VBMI
+static const uint8_t *find_json_escape_avx512(const uint8_t *p, const uint8_t *end) {
+    const __m512i quote = _mm512_set1_epi8('"'), bslash = _mm512_set1_epi8('\\');
+    const __m512i space = _mm512_set1_epi8(0x20);
+    while (p + 64 <= end) {
+        __m512i v = _mm512_loadu_si512((const void *)p);
+        uint64_t mask = _mm512_cmpeq_epi8_mask(v, quote) | _mm512_cmpeq_epi8_mask(v, bslash) |
+                        _mm512_cmplt_epi8_mask(v, space);
+        if (mask) return p + __builtin_ctzll(mask);
+        p += 64;
+    }
+    return find_json_escape_scalar(p, end);
+}
+#endif
+
+#ifdef SGML_NEON_DISPATCH
+static const uint8_t *find_json_escape_neon(const uint8_t *p, const uint8_t *end) {
+    const uint8x16_t quote = vdupq_n_u8('"'), bslash = vdupq_n_u8('\\');
+    const int8x16_t space = vdupq_n_s8(0x20);
+    while (p + 16 <= end) {
+        uint8x16_t v = vld1q_u8(p);
+        uint8x16_t m = vorrq_u8(vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, bslash)),
+                                vcltq_s8(vreinterpretq_s8_u8(v), space));
+        uint64_t bits = vget_lane_u64(vreinterpret_u64_u8(
+            vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+        if (bits) return p + (__builtin_ctzll(bits) >> 2);
+        p += 16;
+    }
+    return find_json_escape_scalar(p, end);
+}
+#endif
+
+sgml_find_lt_fn sgml_select_find_tag(void) {
+    switch (sgml_simd_active()) {
+#ifdef SGML_X86_DISPATCH
+    case SGML_SIMD_AVX512VBMI: return find_tag_avx512;
+    case SGML_SIMD_AVX2:       return find_tag_avx2;
+    case SGML_SIMD_SSSE3:
+    case SGML_SIMD_SSE2:       return find_tag_sse2;
+#endif
+#ifdef SGML_NEON_DISPATCH
+    case SGML_SIMD_NEON:       return find_tag_neon;
+#endif
+    default:                   return find_tag_scalar;
+    }
+}
+
+sgml_find_lt_fn sgml_select_find_close(void) {
+    switch (sgml_simd_active()) {
+#ifdef SGML_X86_DISPATCH
+    case SGML_SIMD_AVX512VBMI: return find_close_avx512;
+    case SGML_SIMD_AVX2:       return find_close_avx2;
+    case SGML_SIMD_SSSE3:
+    case SGML_SIMD_SSE2:       return find_close_sse2;
+#endif
+#ifdef SGML_NEON_DISPATCH
+    case SGML_SIMD_NEON:       return find_close_neon;
+#endif
+    default:                   return find_close_scalar;
+    }
+}
+
+sgml_find_lt_fn sgml_select_find_lt(void) {
+    switch (sgml_simd_active()) {
+#ifdef SGML_X86_DISPATCH
+    case SGML_SIMD_AVX512VBMI: return find_lt_avx512;
+    case SGML_SIMD_AVX2:       return find_lt_avx2;
+    case SGML_SIMD_SSSE3:
+    case SGML_SIMD_SSE2:       return find_lt_sse2;
+#endif
+#ifdef SGML_NEON_DISPATCH
+    case SGML_SIMD_NEON:       return find_lt_neon;
+#endif
+    default:                   return find_lt_scalar;
+    }
+}
+
+sgml_find_lt_fn sgml_select_find_json_escape(void) {
+    switch (sgml_simd_active()) {
+#ifdef SGML_X86_DISPATCH
+    case SGML_SIMD_AVX512VBMI: return find_json_escape_avx512;
+    case SGML_SIMD_AVX2:       return find_json_escape_avx2;
+    case SGML_SIMD_SSSE3:
+    case SGML_SIMD_SSE2:       return find_json_escape_sse2;
+#endif
+#ifdef SGML_NEON_DISPATCH
+    case SGML_SIMD_NEON:       return find_json_escape_neon;
+#endif
+    default:                   return find_json_escape_scalar;
+    }
+}
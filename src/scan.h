@@ -0,0 +1,27 @@
+#ifndef SGML_SCAN_H
+#define SGML_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ---------------------------------------------------------------------------
+// Tag scanning kernels for parse_sgml, one per SIMD tier (see simd.h)
+// ---------------------------------------------------------------------------
+
+// Returns the first '<' in [p, end), or NULL
+typedef const uint8_t *(*sgml_find_lt_fn)(const uint8_t *p, const uint8_t *end);
+
+// Kernels for the active SIMD tier. Resolve once and keep the pointer.
+// find_tag returns the first '<' that may start a tag parse_sgml dispatches
+// on ('<' + D/T/S/F, "</" + D/T), or NULL; find_lt is the plain '<' search.
+sgml_find_lt_fn sgml_select_find_tag(void);
+// find_close: the same for </DOCUMENT> and </TEXT> only ("</DO", "</TE"),
+// for skipping through a <TEXT> body.
+sgml_find_lt_fn sgml_select_find_close(void);
+sgml_find_lt_fn sgml_select_find_lt(void);
+
+// First byte in [p, end) a JSON string can't hold as-is ('"', '\\', < 0x20,
+// >= 0x80), or NULL. Used by the JSON writer to copy clean runs in bulk.
+sgml_find_lt_fn sgml_select_find_json_escape(void);
+
+#endif
@@ -6,6 +6,9 @@
 
 #include "secsgml.h"
 #include "uudecode.h"
+#include "scan.h"
+#include "sgml_thread.h"
+#include "sgml_instrument.h"
 
 // ---------------------------------------------------------------------------
 // Constants
@@ -67,7 +70,7 @@ static inline byte_span ltrim_span(byte_span s) {
     return s;
 }
 
-// Used only for submission metadata and find_uu_bounds (not hot path)
+// Used only for submission metadata (not hot path)
 static const uint8_t *find_subspan(const uint8_t *hay, size_t hay_len,
                                     const char *needle, size_t needle_len) {
     if (needle_len == 0 || hay_len < needle_len) return NULL;
@@ -99,10 +102,15 @@ static inline byte_span value_to_eol(const uint8_t *p, const uint8_t *end) {
 // ---------------------------------------------------------------------------
 // Document array helpers
 // ---------------------------------------------------------------------------
-static int docs_push(sgml_parse_result *r, document doc) {
+static int docs_push(sgml_parse_result *r, document doc, sgml_parse_stats *stats) {
+    (void)stats;  // only read by the INSTR macros
     if (r->doc_count == r->doc_cap) {
         size_t new_cap = r->doc_cap ? r->doc_cap * 2 : DOCS_INITIAL_CAP;
-        document *tmp = (document *)realloc(r->docs, new_cap * sizeof(document));
+        INSTR_START(stats, t0);
+        document *tmp = (document *)sgml_mem_realloc(&r->alloc, r->docs, r->doc_cap * sizeof(document),
+                                                     new_cap * sizeof(document));
+        INSTR_ADD(stats, grow, t0);
+        INSTR(if (stats) stats->grow_count++);
         if (!tmp) return 0;
         r->docs    = tmp;
         r->doc_cap = new_cap;
@@ -125,25 +133,15 @@ static inline int is_end_line(const uint8_t *p, size_t len) {
     return len == 3 || is_space(p[3]);
 }
 
-static int find_uu_bounds(const uint8_t *text_start, const uint8_t *text_end,
-                           const uint8_t **enc_start, const uint8_t **enc_end) {
+// First encoded line after a "begin 644" line in the first three lines.
+// Uses the SIMD newline scan: HTML bodies are often one multi-MB line.
+static int find_uu_begin(const uint8_t *text_start, const uint8_t *text_end,
+                         const uint8_t **enc_start, uu_find_newline_fn find_nl) {
     const uint8_t *p = text_start;
     for (int line = 0; line < 3 && p < text_end; line++) {
-        const uint8_t *eol = find_eol(p, text_end);
+        const uint8_t *eol = find_nl(p, text_end);
         if (is_begin_644(p, (size_t)(eol - p))) {
-            const uint8_t *enc = skip_eol(eol, text_end);
-            const uint8_t *scan = enc;
-            const uint8_t *enc_e = text_end;
-            while (scan < text_end) {
-                const uint8_t *le = find_eol(scan, text_end);
-                if (is_end_line(scan, (size_t)(le - scan))) {
-                    enc_e = scan;
-                    break;
-                }
-                scan = skip_eol(le, text_end);
-            }
-            *enc_start = enc;
-            *enc_end   = enc_e;
+            *enc_start = skip_eol(eol, text_end);
             return 1;
         }
         p = skip_eol(eol, text_end);
@@ -151,28 +149,39 @@ static int find_uu_bounds(const uint8_t *text_start, const uint8_t *text_end,
     return 0;
 }
 
-// Pre-scan uuencoded payload to compute exact decoded size.
-// Uses the same length-char rules as uudecode, so malformed lines are still counted safely.
-static size_t uu_decoded_size(const uint8_t *enc_start, const uint8_t *enc_end, int *capped) {
+// Start of the "end" line, or text_end. The fused decode finds it on its own;
+// the parallel path needs it up front to split the payload.
+static const uint8_t *find_uu_end(const uint8_t *enc_start, const uint8_t *text_end,
+                                  uu_find_newline_fn find_nl) {
+    const uint8_t *scan = enc_start;
+    while (scan < text_end) {
+        const uint8_t *le = find_nl(scan, text_end);
+        if (is_end_line(scan, (size_t)(le - scan))) return scan;
+        scan = skip_eol(le, text_end);
+    }
+    return text_end;
+}
+
+// find_uu_end that also adds up the line length characters on the way, the
+// same sum uudecode_size gives for [enc_start, "end" line): one pass over
+// the lines for the document index instead of two
+static const uint8_t *find_uu_end_sized(const uint8_t *enc_start, const uint8_t *text_end,
+                                        uu_find_newline_fn find_nl, size_t *size) {
+    const uint8_t *scan = enc_start;
     size_t total = 0;
-    const uint8_t *p = enc_start;
-    if (capped) *capped = 0;
-    while (p < enc_end) {
-        const uint8_t *eol = find_eol(p, enc_end);
-        if (p < eol) {
-            uint8_t len_char = *p;
-            int nbytes = (len_char - 32) & 0x3f;
-            if (nbytes == 0) break;
-            if (total > UU_DECODE_MAX - (size_t)nbytes) {
-                total = UU_DECODE_MAX;
-                if (capped) *capped = 1;
-                break;
-            }
+    int terminated = 0;
+    while (scan < text_end) {
+        const uint8_t *le = find_nl(scan, text_end);
+        if (is_end_line(scan, (size_t)(le - scan))) break;
+        if (!terminated && le > scan && *scan != '\r') {
+            int nbytes = (*scan - 32) & 0x3f;
+            if (nbytes == 0) terminated = 1;
             total += (size_t)nbytes;
         }
-        p = skip_eol(eol, enc_end);
+        scan = skip_eol(le, text_end);
     }
-    return total;
+    *size = total > UU_DECODE_MAX ? UU_DECODE_MAX : total;
+    return scan < text_end ? scan : text_end;
 }
 
 static void strip_wrappers(const uint8_t **start, const uint8_t **end) {
@@ -202,6 +211,83 @@ static void strip_wrappers(const uint8_t **start, const uint8_t **end) {
     *end   = e;
 }
 
+// ---------------------------------------------------------------------------
+// Document filter
+// ---------------------------------------------------------------------------
+static inline uint8_t ascii_upper(uint8_t c) {
+    return (c >= 'a' && c <= 'z') ? (uint8_t)(c - 32) : c;
+}
+
+// '*' and '?' glob over a span, case-insensitive; backtracks to the last '*'
+static int glob_match(const char *pat, byte_span s) {
+    size_t i = 0;
+    const char *star = NULL;
+    size_t star_i = 0;
+    while (i < s.len) {
+        if (*pat == '*') {
+            star   = pat++;
+            star_i = i;
+        } else if (*pat && (*pat == '?' || ascii_upper((uint8_t)*pat) == ascii_upper(s.ptr[i]))) {
+            pat++;
+            i++;
+        } else if (star) {
+            pat = star + 1;
+            i   = ++star_i;
+        } else {
+            return 0;
+        }
+    }
+    while (*pat == '*') pat++;
+    return *pat == '\0';
+}
+
+static int glob_any(const char *const *pats, size_t n, byte_span s) {
+    for (size_t i = 0; i < n; i++) {
+        if (pats[i] && glob_match(pats[i], s)) return 1;
+    }
+    return 0;
+}
+
+static int has_extension(byte_span name, const char *ext) {
+    size_t n = strlen(ext);
+    if (name.len <= n || name.ptr[name.len - n - 1] != '.') return 0;
+    const uint8_t *p = name.ptr + name.len - n;
+    for (size_t i = 0; i < n; i++) {
+        if (ascii_upper(p[i]) != ascii_upper((uint8_t)ext[i])) return 0;
+    }
+    return 1;
+}
+
+// SEQUENCE as a number; 0 if it has no digits or anything but digits
+static int parse_sequence(byte_span s, unsigned long *out) {
+    unsigned long v = 0;
+    if (s.len == 0) return 0;
+    for (size_t i = 0; i < s.len; i++) {
+        if (s.ptr[i] < '0' || s.ptr[i] > '9') return 0;
+        v = v * 10 + (unsigned long)(s.ptr[i] - '0');
+    }
+    *out = v;
+    return 1;
+}
+
+int sgml_filter_match(const sgml_filter *f, const document_meta *meta) {
+    if (!f) return 1;
+    if (f->ntypes && !glob_any(f->types, f->ntypes, meta->type)) return 0;
+    if (f->nexclude_types && glob_any(f->exclude_types, f->nexclude_types, meta->type)) return 0;
+    if (f->nextensions) {
+        size_t i = 0;
+        while (i < f->nextensions && !(f->extensions[i] && has_extension(meta->filename, f->extensions[i]))) i++;
+        if (i == f->nextensions) return 0;
+    }
+    if (f->min_sequence || f->max_sequence) {
+        unsigned long seq;
+        if (!parse_sequence(meta->sequence, &seq)) return 0;
+        if (f->min_sequence && seq < f->min_sequence) return 0;
+        if (f->max_sequence && seq > f->max_sequence) return 0;
+    }
+    return f->fn ? f->fn(f->user, meta) != 0 : 1;
+}
+
 // ---------------------------------------------------------------------------
 // Single-pass scanner state
 // ---------------------------------------------------------------------------
@@ -209,48 +295,214 @@ typedef enum {
     STATE_BETWEEN,      // between documents
     STATE_IN_DOC_META,  // inside <DOCUMENT>, before <TEXT>
     STATE_IN_TEXT,      // inside <TEXT>...</TEXT>
+    STATE_SKIP,         // document rejected by the filter, up to </DOCUMENT>
 } scan_state;
 
-// ---------------------------------------------------------------------------
-// Main parse_sgml -- single pass over '<' characters
-// ---------------------------------------------------------------------------
-sgml_parse_result parse_sgml(const uint8_t *buf, size_t len, sgml_parse_stats *stats) {
-    sgml_parse_result result = {0};
-    result.status = SGML_STATUS_OK;
-    result.docs    = (document *)malloc(DOCS_INITIAL_CAP * sizeof(document));
-    result.doc_cap = result.docs ? DOCS_INITIAL_CAP : 0;
-    if (!result.docs) {
-        result.status = SGML_STATUS_OOM;
-        return result;
+// Longest tag we dispatch on is <DESCRIPTION>. When more input may follow,
+// a '<' closer than this to the end of the buffer is left for the next feed.
+#define TAG_MAX_LEN 13
+
+// Called once per completed document. Returns 0 to abort the scan.
+typedef int (*doc_sink)(void *ctx, document *doc);
+
+// Everything the scanner needs to resume where it stopped. parse_sgml runs it
+// once over the whole buffer; sgml_stream runs it once per fed chunk.
+typedef struct {
+    scan_state         state;
+    document           cur;        // document being built
+    const uint8_t     *doc_start;  // byte after <DOCUMENT> of cur
+    sgml_status        status;
+    sgml_parse_stats  *stats;
+    sgml_parse_options opts;
+    // SIMD kernels, resolved once; find_text_end stands in for find_tag
+    // inside <TEXT>
+    sgml_find_lt_fn    find_tag;
+    sgml_find_lt_fn    find_text_end;
+    uu_find_newline_fn find_nl;
+    // parse_submission_into: header to fill from [header_start, first
+    // <DOCUMENT>) when the scan reaches it; NULL once done
+    submission_metadata *header;
+    const uint8_t      *header_start;
+    // <TEXT> body of cur, for the document index
+    const uint8_t      *text_start;
+    const uint8_t      *text_end;
+    int                 index_only;  // lazy bounds also size the payload
+    size_t              uu_size;     // of cur, when index_only
+} sgml_scanner;
+
+static sgml_status parse_header_region(submission_metadata *m, const uint8_t *buf, size_t len);
+
+static void scanner_init(sgml_scanner *s, const sgml_parse_options *opts, sgml_parse_stats *stats) {
+    memset(s, 0, sizeof(*s));
+    s->state  = STATE_BETWEEN;
+    s->status = SGML_STATUS_OK;
+    s->stats  = stats;
+    if (opts) s->opts = *opts;
+    if (s->opts.decode_threads <= 0) s->opts.decode_threads = sgml_cpu_count();
+    if (s->opts.parallel_decode_min == 0) s->opts.parallel_decode_min = SGML_PARALLEL_DECODE_MIN;
+    s->find_tag = sgml_select_find_tag();
+    s->find_text_end = s->opts.no_text_skip ? s->find_tag : sgml_select_find_close();
+    s->find_nl = uu_select_find_newline();
+}
+
+// Large payloads: size and decode segments on several threads
+static sgml_status decode_parallel(document *doc, int threads, const sgml_allocator *alloc,
+                                   sgml_parse_stats *stats) {
+    (void)stats;  // only read by the INSTR macros
+    uu_plan plan;
+    sgml_status st = SGML_STATUS_OK;
+    INSTR_START(stats, t0);
+    size_t dec_sz = uu_plan_segments(&plan, doc->content_start, doc->content_len, threads);
+    INSTR_ADD(stats, uu_size, t0);
+    if (dec_sz > UU_DECODE_MAX) {
+        dec_sz = UU_DECODE_MAX;
+        st = SGML_STATUS_TRUNCATED;
     }
+    doc->decoded = (uint8_t *)sgml_mem_alloc(alloc, dec_sz ? dec_sz : 1);
+    if (!doc->decoded) return SGML_STATUS_OOM;
+    INSTR_START(stats, t1);
+    doc->decoded_len = uudecode_planned(&plan, doc->decoded, dec_sz);
+    INSTR_ADD(stats, decode, t1);
+    return st;
+}
 
-    const uint8_t *p   = buf;
-    const uint8_t *end = buf + len;
+// Payloads below the parallel threshold: one pass over the lines finds the
+// "end" line, sizes and decodes. Well-formed lines never decode to more than
+// 3/4 of their encoded bytes, so that bound rarely needs to grow; the buffer
+// is shrunk to fit afterwards. Sets content_len to the "end" line.
+static sgml_status decode_fused(document *doc, const uint8_t *text_end, uu_find_newline_fn find_nl,
+                                const sgml_allocator *alloc, sgml_parse_stats *stats) {
+    (void)stats;  // only read by the INSTR macros
+    const uint8_t *enc_start = doc->content_start;
+    size_t span = (size_t)(text_end - enc_start);
+    size_t cap = span / 4 * 3 + 64;
+    if (cap > UU_DECODE_MAX) cap = UU_DECODE_MAX;
 
-    scan_state state = STATE_BETWEEN;
-    document   cur   = {0};          // document being built
+    uu_fused_state st = {0};
+    uint8_t *buf = (uint8_t *)sgml_mem_alloc(alloc, cap);
+    while (buf) {
+        INSTR_START(stats, t0);
+        int full = uudecode_fused(enc_start, span, buf, cap, cap == UU_DECODE_MAX, &st) == UU_FUSED_FULL;
+        INSTR_ADD(stats, decode, t0);
+        if (!full) break;
+        size_t new_cap = cap > UU_DECODE_MAX / 2 ? UU_DECODE_MAX : cap * 2;
+        INSTR_START(stats, t1);
+        uint8_t *tmp = (uint8_t *)sgml_mem_realloc(alloc, buf, cap, new_cap);
+        INSTR_ADD(stats, grow, t1);
+        INSTR(if (stats) stats->grow_count++);
+        if (!tmp) {
+            sgml_mem_free(alloc, buf);
+            buf = NULL;
+            break;
+        }
+        buf = tmp;
+        cap = new_cap;
+    }
+    if (!buf) {
+        doc->content_len = (size_t)(find_uu_end(enc_start, text_end, find_nl) - enc_start);
+        return SGML_STATUS_OOM;
+    }
+    doc->content_len = st.enc_len;
+
+    INSTR_START(stats, t2);
+    uint8_t *fit = (uint8_t *)sgml_mem_realloc(alloc, buf, cap, st.out_pos ? st.out_pos : 1);
+    INSTR_ADD(stats, grow, t2);
+    INSTR(if (stats) stats->grow_count++);
+    doc->decoded     = fit ? fit : buf;
+    doc->decoded_len = st.out_pos;
+    return st.truncated ? SGML_STATUS_TRUNCATED : SGML_STATUS_OK;
+}
+
+// </TEXT> reached: detect uuencoding and decode, or strip wrappers in place
+static void finish_text(sgml_scanner *s, const uint8_t *text_end_ptr) {
+    document *cur = &s->cur;
+    sgml_parse_stats *stats = s->stats;
+    const uint8_t *enc_start;
+    INSTR(if (stats && (uint64_t)(text_end_ptr - cur->content_start) > stats->largest_doc)
+              stats->largest_doc = (uint64_t)(text_end_ptr - cur->content_start));
+
+    INSTR_START(stats, t0);
+    int uu = find_uu_begin(cur->content_start, text_end_ptr, &enc_start, s->find_nl);
+    INSTR_ADD(stats, uu_bounds, t0);
+
+    if (uu) {
+        sgml_status st = SGML_STATUS_OK;
+        cur->is_uuencoded  = 1;
+        cur->content_start = enc_start;
+        if (s->index_only) {
+            INSTR_START(stats, t1);
+            cur->content_len = (size_t)(find_uu_end_sized(enc_start, text_end_ptr, s->find_nl,
+                                                          &s->uu_size) - enc_start);
+            INSTR_ADD(stats, uu_bounds, t1);
+        } else if (s->opts.lazy_decode) {
+            INSTR_START(stats, t1);
+            cur->content_len = (size_t)(find_uu_end(enc_start, text_end_ptr, s->find_nl) - enc_start);
+            INSTR_ADD(stats, uu_bounds, t1);
+        } else if (s->opts.decode_threads > 1 &&
+                   (size_t)(text_end_ptr - enc_start) >= s->opts.parallel_decode_min) {
+            INSTR_START(stats, t1);
+            cur->content_len = (size_t)(find_uu_end(enc_start, text_end_ptr, s->find_nl) - enc_start);
+            INSTR_ADD(stats, uu_bounds, t1);
+            st = decode_parallel(cur, s->opts.decode_threads, s->opts.allocator, stats);
+        } else {
+            st = decode_fused(cur, text_end_ptr, s->find_nl, s->opts.allocator, stats);
+        }
+        if (st != SGML_STATUS_OK) s->status = st;
+        if (stats) stats->uuencoded_count++;
+        INSTR(if (stats) {
+            stats->uuencoded_bytes += cur->content_len;
+            stats->decoded_bytes   += cur->decoded_len;
+        });
+    } else {
+        cur->is_uuencoded = 0;
+        const uint8_t *cs = cur->content_start;
+        const uint8_t *ce = text_end_ptr;
+        INSTR_START(stats, t1);
+        strip_wrappers(&cs, &ce);
+        INSTR_ADD(stats, strip, t1);
+        cur->content_start = cs;
+        cur->content_len   = (size_t)(ce - cs);
+        INSTR(if (stats) stats->plain_bytes += cur->content_len);
+    }
+}
+
+// Value tags are read to end of line. Without a line ending in the buffer the
+// value may continue in the next chunk, so the tag is retried later.
+static inline int value_incomplete(const sgml_scanner *s, const uint8_t *v,
+                                   const uint8_t *end, int final) {
+    if (final || s->state != STATE_IN_DOC_META) return 0;
+    return find_eol(v, end) == end;
+}
+
+// ---------------------------------------------------------------------------
+// Tag scan -- single pass over '<' characters
+//
+// Scans [p, end). With final == 0 the scan stops at the first '<' that could
+// be a tag or value cut off by the end of the buffer and returns it, so the
+// caller can append more input and resume there. Returns NULL if the sink
+// failed (s->status says why).
+// ---------------------------------------------------------------------------
+static const uint8_t *scan_tags(sgml_scanner *s, const uint8_t *p, const uint8_t *end,
+                                int final, doc_sink sink, void *ctx) {
     while (p < end) {
 
-        // Jump to next '<' -- memchr is SIMD-optimized on Linux/glibc
-        const uint8_t *lt = (const uint8_t *)memchr(p, '<', (size_t)(end - p));
-        if (!lt) { break; }
+        // Jump to the next '<' that can start a tag we dispatch on; the
+        // SIMD kernel picked at init skips all other markup in bulk. Inside
+        // <TEXT> only </TEXT> and </DOCUMENT> change state, so the body is
+        // skipped with the closing-tag kernel.
+        const uint8_t *lt = s->state == STATE_IN_TEXT || s->state == STATE_SKIP
+                                ? s->find_text_end(p, end) : s->find_tag(p, end);
+        if (!lt) { return end; }
 
         // How many bytes remain after '<'
         size_t remain = (size_t)(end - lt);
+        if (!final && remain < TAG_MAX_LEN) { return lt; }
 
         // Dispatch on first char after '<'
-        // All our tags start with distinct leading chars:
-        //   D -> DOCUMENT>
-        //   / -> /DOCUMENT> or /TEXT>
-        //   T -> TEXT> or TYPE>
-        //   S -> SEQUENCE>
-        //   F -> FILENAME>
-        //   E -> (none, but DESCRIPTION starts with D... wait no)
-        //   d -> DESCRIPTION starts with D uppercase
-        // Actually: TYPE and TEXT both start with T, DOCUMENT and DESCRIPTION both start with D
-        // So we need two chars for disambiguation in those cases.
-
-        if (remain < 2) { break; }
+        // TYPE and TEXT both start with T, DOCUMENT and DESCRIPTION both
+        // start with D, so those need a second comparison to disambiguate.
+
+        if (remain < 2) { return end; }
 
         uint8_t c1 = lt[1];
 
@@ -258,15 +510,23 @@ sgml_parse_result parse_sgml(const uint8_t *buf, size_t len, sgml_parse_stats *s
             // Could be <DOCUMENT> or <DESCRIPTION>
             if (remain >= 10 && memcmp(lt+1, "DOCUMENT>", 9) == 0) {
                 // <DOCUMENT>
-                if (state == STATE_BETWEEN) {
-                    cur = (document){0};
-                    state = STATE_IN_DOC_META;
+                if (s->state == STATE_BETWEEN) {
+                    if (s->header) {
+                        parse_header_region(s->header, s->header_start, (size_t)(lt - s->header_start));
+                        s->header = NULL;
+                    }
+                    s->cur        = (document){0};
+                    s->doc_start  = lt + 10;
+                    s->text_start = NULL;
+                    s->text_end   = NULL;
+                    s->state     = STATE_IN_DOC_META;
                 }
                 p = lt + 10;
             } else if (remain >= 13 && memcmp(lt+1, "DESCRIPTION>", 12) == 0) {
                 // <DESCRIPTION>
-                if (state == STATE_IN_DOC_META) {
-                    cur.meta.description = value_to_eol(lt + 13, end);
+                if (value_incomplete(s, lt + 13, end, final)) return lt;
+                if (s->state == STATE_IN_DOC_META) {
+                    s->cur.meta.description = value_to_eol(lt + 13, end);
                 }
                 p = lt + 13;
             } else {
@@ -279,63 +539,31 @@ sgml_parse_result parse_sgml(const uint8_t *buf, size_t len, sgml_parse_stats *s
 
             if (c2 == 'D' && remain >= 11 && memcmp(lt+1, "/DOCUMENT>", 10) == 0) {
                 // </DOCUMENT>
-                if (state == STATE_IN_DOC_META || state == STATE_IN_TEXT) {
-
-                    // UU detect + decode
-                    if (state == STATE_IN_TEXT && cur.content_start) {
-                        const uint8_t *text_end_ptr = lt; // shouldn't happen but safe fallback
-                        // content_start was set at <TEXT>, content_len at </TEXT>
-                        // we already set these at </TEXT>, so just finalize
-                    }
-
-                    if (stats) stats->doc_count++;
-                    if (!docs_push(&result, cur)) {
-                        if (cur.decoded) free(cur.decoded);
-                        result.status = SGML_STATUS_OOM;
-                        return result;
+                if (s->state == STATE_SKIP ||
+                    (s->state == STATE_IN_DOC_META && !s->text_start &&
+                     !sgml_filter_match(s->opts.filter, &s->cur.meta))) {
+                    // Rejected at <TEXT>, or here if it had none
+                    if (s->stats) s->stats->filtered_count++;
+                    s->cur   = (document){0};
+                    s->state = STATE_BETWEEN;
+                } else if (s->state == STATE_IN_DOC_META || s->state == STATE_IN_TEXT) {
+                    if (s->stats) s->stats->doc_count++;
+                    if (!sink(ctx, &s->cur)) {
+                        sgml_mem_free(s->opts.allocator, s->cur.decoded);
+                        s->cur   = (document){0};
+                        s->state = STATE_BETWEEN;
+                        return NULL;
                     }
-                    cur   = (document){0};
-                    state = STATE_BETWEEN;
-                    p = lt + 11;
-                    continue;
+                    s->cur   = (document){0};
+                    s->state = STATE_BETWEEN;
                 }
                 p = lt + 11;
             } else if (c2 == 'T' && remain >= 7 && memcmp(lt+1, "/TEXT>", 6) == 0) {
                 // </TEXT>
-                if (state == STATE_IN_TEXT) {
-                    const uint8_t *text_end_ptr = lt;
-
-                    const uint8_t *enc_start, *enc_end;
-                    int is_uu = find_uu_bounds(cur.content_start, text_end_ptr, &enc_start, &enc_end);
-
-                    if (is_uu) {
-                        cur.is_uuencoded  = 1;
-                        cur.content_start = enc_start;
-                        cur.content_len   = (size_t)(enc_end - enc_start);
-                        int capped = 0;
-                        size_t dec_sz = uu_decoded_size(enc_start, enc_end, &capped);
-                        if (capped) result.status = SGML_STATUS_TRUNCATED;
-                        cur.decoded = (uint8_t *)malloc(dec_sz ? dec_sz : 1);
-                        if (cur.decoded) {
-                            cur.decoded_len = uudecode(enc_start, cur.content_len, cur.decoded, dec_sz);
-                            if (cur.decoded_len != dec_sz)
-                                result.status = SGML_STATUS_TRUNCATED;
-                        } else {
-                            result.status = SGML_STATUS_OOM;
-                        }
-                        if (stats) stats->uuencoded_count++;
-                    } else {
-                        cur.is_uuencoded = 0;
-                        const uint8_t *cs = cur.content_start;
-                        const uint8_t *ce = text_end_ptr;
-                        strip_wrappers(&cs, &ce);
-                        cur.content_start = cs;
-                        cur.content_len   = (size_t)(ce - cs);
-                    }
-
-                    state = STATE_IN_DOC_META; // back to meta state until </DOCUMENT>
-                    p = lt + 7;
-                    continue;
+                if (s->state == STATE_IN_TEXT) {
+                    s->text_end = lt;
+                    finish_text(s, lt);
+                    s->state = STATE_IN_DOC_META; // back to meta state until </DOCUMENT>
                 }
                 p = lt + 7;
             } else {
@@ -346,15 +574,21 @@ sgml_parse_result parse_sgml(const uint8_t *buf, size_t len, sgml_parse_stats *s
             // Could be <TEXT> or <TYPE>
             if (remain >= 6 && memcmp(lt+1, "TEXT>", 5) == 0) {
                 // <TEXT>
-                if (state == STATE_IN_DOC_META) {
-                    cur.content_start = lt + 6; // points to byte after <TEXT>
-                    state = STATE_IN_TEXT;
+                if (s->state == STATE_IN_DOC_META) {
+                    s->text_start = lt + 6;
+                    if (sgml_filter_match(s->opts.filter, &s->cur.meta)) {
+                        s->cur.content_start = lt + 6; // points to byte after <TEXT>
+                        s->state = STATE_IN_TEXT;
+                    } else {
+                        s->state = STATE_SKIP;
+                    }
                 }
                 p = lt + 6;
             } else if (remain >= 6 && memcmp(lt+1, "TYPE>", 5) == 0) {
                 // <TYPE>
-                if (state == STATE_IN_DOC_META) {
-                    cur.meta.type = value_to_eol(lt + 6, end);
+                if (value_incomplete(s, lt + 6, end, final)) return lt;
+                if (s->state == STATE_IN_DOC_META) {
+                    s->cur.meta.type = value_to_eol(lt + 6, end);
                 }
                 p = lt + 6;
             } else {
@@ -363,15 +597,17 @@ sgml_parse_result parse_sgml(const uint8_t *buf, size_t len, sgml_parse_stats *s
 
         } else if (c1 == 'S' && remain >= 10 && memcmp(lt+1, "SEQUENCE>", 9) == 0) {
             // <SEQUENCE>
-            if (state == STATE_IN_DOC_META) {
-                cur.meta.sequence = value_to_eol(lt + 10, end);
+            if (value_incomplete(s, lt + 10, end, final)) return lt;
+            if (s->state == STATE_IN_DOC_META) {
+                s->cur.meta.sequence = value_to_eol(lt + 10, end);
             }
             p = lt + 10;
 
         } else if (c1 == 'F' && remain >= 10 && memcmp(lt+1, "FILENAME>", 9) == 0) {
             // <FILENAME>
-            if (state == STATE_IN_DOC_META) {
-                cur.meta.filename = value_to_eol(lt + 10, end);
+            if (value_incomplete(s, lt + 10, end, final)) return lt;
+            if (s->state == STATE_IN_DOC_META) {
+                s->cur.meta.filename = value_to_eol(lt + 10, end);
             }
             p = lt + 10;
 
@@ -382,20 +618,390 @@ sgml_parse_result parse_sgml(const uint8_t *buf, size_t len, sgml_parse_stats *s
 
     }
 
+    return end;
+}
+
+// scan_tags, adding the time not spent in another stage to tag_scan
+static const uint8_t *scan_tags_counted(sgml_scanner *s, const uint8_t *p, const uint8_t *end,
+                                        int final, doc_sink sink, void *ctx) {
+#ifdef SECSGML_INSTRUMENT
+    sgml_parse_stats *stats = s->stats;
+    if (stats) {
+        const sgml_stage_times *t = &stats->time;
+        uint64_t inner0 = t->uu_bounds + t->uu_size + t->decode + t->strip + t->grow + t->callback;
+        uint64_t t0 = sgml_now_ns();
+        const uint8_t *stop = scan_tags(s, p, end, final, sink, ctx);
+        uint64_t elapsed = sgml_now_ns() - t0;
+        uint64_t inner = t->uu_bounds + t->uu_size + t->decode + t->strip + t->grow + t->callback - inner0;
+        stats->time.tag_scan += elapsed > inner ? elapsed - inner : 0;
+        return stop;
+    }
+#endif
+    return scan_tags(s, p, end, final, sink, ctx);
+}
+
+// ---------------------------------------------------------------------------
+// Main parse_sgml -- whole submission in one buffer
+// ---------------------------------------------------------------------------
+typedef struct {
+    sgml_parse_result *r;
+    sgml_parse_stats  *stats;
+} result_ctx;
+
+static int result_sink(void *ctx, document *doc) {
+    result_ctx *rc = (result_ctx *)ctx;
+    return docs_push(rc->r, *doc, rc->stats);
+}
+
+// One scan of the whole buffer into r; with header set, the header region
+// goes to it on the way
+static sgml_status parse_buffer(sgml_parse_result *r, submission_metadata *header,
+                                const uint8_t *buf, size_t len,
+                                const sgml_parse_options *opts, sgml_parse_stats *stats) {
+    sgml_allocator alloc = {0};
+    if (opts && opts->allocator) alloc = *opts->allocator;
+    if (memcmp(&alloc, &r->alloc, sizeof(alloc)) != 0) {
+        free_sgml_parse_result(r);
+        r->alloc = alloc;
+    }
+    reset_sgml_parse_result(r);
+    r->status = SGML_STATUS_OK;
+    if (!r->docs) {
+        r->docs    = (document *)sgml_mem_alloc(&r->alloc, DOCS_INITIAL_CAP * sizeof(document));
+        r->doc_cap = r->docs ? DOCS_INITIAL_CAP : 0;
+        if (!r->docs) {
+            r->status = SGML_STATUS_OOM;
+            return r->status;
+        }
+    }
+
+    sgml_scanner sc;
+    scanner_init(&sc, opts, stats);
+    sc.opts.allocator = &r->alloc;
+    sc.header         = header;
+    sc.header_start   = buf;
+
+    result_ctx rc = { r, stats };
+    if (!scan_tags_counted(&sc, buf, buf + len, 1, result_sink, &rc)) {
+        r->status = SGML_STATUS_OOM;
+        return r->status;
+    }
+    // No <DOCUMENT> at all: everything is header
+    if (sc.header) parse_header_region(sc.header, buf, len);
+    r->status = sc.status;
+    return r->status;
+}
+
+sgml_status parse_sgml_into(sgml_parse_result *r, const uint8_t *buf, size_t len,
+                            const sgml_parse_options *opts, sgml_parse_stats *stats) {
+    return parse_buffer(r, NULL, buf, len, opts, stats);
+}
+
+sgml_status parse_submission_into(sgml_parse_result *r, submission_metadata *m,
+                                  const uint8_t *buf, size_t len,
+                                  const sgml_parse_options *opts, sgml_parse_stats *stats) {
+    m->count  = 0;
+    m->status = SGML_STATUS_OK;
+    parse_buffer(r, m, buf, len, opts, stats);
+    return m->status != SGML_STATUS_OK ? m->status : r->status;
+}
+
+sgml_parse_result parse_sgml(const uint8_t *buf, size_t len, sgml_parse_stats *stats) {
+    sgml_parse_result result = {0};
+    parse_sgml_into(&result, buf, len, NULL, stats);
     return result;
 }
 
-void free_sgml_parse_result(sgml_parse_result *r) {
+void reset_sgml_parse_result(sgml_parse_result *r) {
     if (!r) return;
     for (size_t i = 0; i < r->doc_count; i++) {
-        if (r->docs[i].decoded) free(r->docs[i].decoded);
+        sgml_mem_free(&r->alloc, r->docs[i].decoded);
     }
-    free(r->docs);
+    r->doc_count = 0;
+    r->status    = SGML_STATUS_OK;
+}
+
+void free_sgml_parse_result(sgml_parse_result *r) {
+    if (!r) return;
+    reset_sgml_parse_result(r);
+    sgml_mem_free(&r->alloc, r->docs);
     r->docs      = NULL;
     r->doc_count = 0;
     r->doc_cap   = 0;
 }
 
+// ---------------------------------------------------------------------------
+// Document index -- the lazy scan, keeping offsets instead of documents
+// ---------------------------------------------------------------------------
+typedef struct {
+    sgml_doc_index     *ix;
+    const sgml_scanner *sc;
+    const uint8_t      *base;
+} index_ctx;
+
+static int index_sink(void *ctx, document *doc) {
+    index_ctx *ic = (index_ctx *)ctx;
+    sgml_doc_index *ix = ic->ix;
+    const sgml_scanner *sc = ic->sc;
+    if (ix->doc_count == ix->doc_cap) {
+        size_t new_cap = ix->doc_cap ? ix->doc_cap * 2 : DOCS_INITIAL_CAP;
+        sgml_index_entry *tmp = (sgml_index_entry *)sgml_mem_realloc(
+            &ix->alloc, ix->docs, ix->doc_cap * sizeof(sgml_index_entry),
+            new_cap * sizeof(sgml_index_entry));
+        if (!tmp) return 0;
+        ix->docs    = tmp;
+        ix->doc_cap = new_cap;
+    }
+    sgml_index_entry *e = &ix->docs[ix->doc_count++];
+    memset(e, 0, sizeof(*e));
+    e->meta       = doc->meta;
+    e->doc_offset = (uint64_t)(sc->doc_start - DOC_OPEN_LEN - ic->base);
+    if (sc->text_start && sc->text_end) {
+        e->text_offset = (uint64_t)(sc->text_start - ic->base);
+        e->text_end    = (uint64_t)(sc->text_end - ic->base);
+    }
+    if (doc->content_start) {
+        e->content_offset = (uint64_t)(doc->content_start - ic->base);
+        e->content_len    = doc->content_len;
+    }
+    e->is_uuencoded = doc->is_uuencoded;
+    e->decoded_size = doc->is_uuencoded ? sc->uu_size : 0;
+    return 1;
+}
+
+// One index scan of buf; with header set, the header region goes to it on
+// the way, as in parse_buffer
+static sgml_status index_buffer(sgml_doc_index *ix, submission_metadata *header,
+                                const uint8_t *buf, size_t len, sgml_parse_stats *stats) {
+    ix->doc_count  = 0;
+    ix->source_len = len;
+    ix->status     = SGML_STATUS_OK;
+
+    sgml_scanner sc;
+    scanner_init(&sc, NULL, stats);
+    sc.index_only   = 1;
+    sc.header       = header;
+    sc.header_start = buf;
+
+    index_ctx ic = { ix, &sc, buf };
+    if (!scan_tags_counted(&sc, buf, buf + len, 1, index_sink, &ic)) {
+        ix->status = SGML_STATUS_OOM;
+        return ix->status;
+    }
+    // No <DOCUMENT> at all: everything is header
+    if (sc.header) parse_header_region(sc.header, buf, len);
+    ix->status = sc.status;
+    return ix->status;
+}
+
+sgml_status parse_sgml_index_into(sgml_doc_index *ix, const uint8_t *buf, size_t len,
+                                  sgml_parse_stats *stats) {
+    return index_buffer(ix, NULL, buf, len, stats);
+}
+
+sgml_status parse_submission_index_into(sgml_doc_index *ix, submission_metadata *m,
+                                        const uint8_t *buf, size_t len, sgml_parse_stats *stats) {
+    m->count  = 0;
+    m->status = SGML_STATUS_OK;
+    index_buffer(ix, m, buf, len, stats);
+    return m->status != SGML_STATUS_OK ? m->status : ix->status;
+}
+
+void free_sgml_doc_index(sgml_doc_index *ix) {
+    if (!ix) return;
+    sgml_mem_free(&ix->alloc, ix->docs);
+    sgml_mem_free(&ix->alloc, ix->backing);
+    ix->docs      = NULL;
+    ix->backing   = NULL;
+    ix->doc_count = 0;
+    ix->doc_cap   = 0;
+}
+
+// ---------------------------------------------------------------------------
+// On-demand decode -- for documents parsed with lazy_decode
+// ---------------------------------------------------------------------------
+sgml_status sgml_decode_document(document *doc, const sgml_parse_options *opts) {
+    if (!doc || !doc->is_uuencoded || doc->decoded) return SGML_STATUS_OK;
+    int threads = opts ? opts->decode_threads : 0;
+    size_t par_min = opts && opts->parallel_decode_min ? opts->parallel_decode_min
+                                                        : SGML_PARALLEL_DECODE_MIN;
+    if (threads <= 0) threads = sgml_cpu_count();
+    doc->decoded_len = 0;
+    if (threads > 1 && doc->content_len >= par_min)
+        return decode_parallel(doc, threads, opts ? opts->allocator : NULL, NULL);
+    return decode_fused(doc, doc->content_start + doc->content_len, uu_select_find_newline(),
+                        opts ? opts->allocator : NULL, NULL);
+}
+
+size_t sgml_decoded_size(const document *doc) {
+    if (!doc || !doc->is_uuencoded) return 0;
+    if (doc->decoded) return doc->decoded_len;
+    size_t n = uudecode_size(doc->content_start, doc->content_len);
+    return n > UU_DECODE_MAX ? UU_DECODE_MAX : n;
+}
+
+sgml_status sgml_decode_document_into(const document *doc, uint8_t *out, size_t out_cap,
+                                      size_t *out_len) {
+    *out_len = 0;
+    if (!doc || !doc->is_uuencoded) return SGML_STATUS_OK;
+    if (out_cap > UU_DECODE_MAX) out_cap = UU_DECODE_MAX;
+    uu_fused_state st = {0};
+    uudecode_fused(doc->content_start, doc->content_len, out, out_cap, 1, &st);
+    *out_len = st.out_pos;
+    return st.truncated ? SGML_STATUS_TRUNCATED : SGML_STATUS_OK;
+}
+
+// ---------------------------------------------------------------------------
+// Stats
+// ---------------------------------------------------------------------------
+void sgml_parse_stats_add(sgml_parse_stats *dst, const sgml_parse_stats *src) {
+    dst->doc_count       += src->doc_count;
+    dst->uuencoded_count += src->uuencoded_count;
+    dst->filtered_count  += src->filtered_count;
+    dst->uuencoded_bytes += src->uuencoded_bytes;
+    dst->decoded_bytes   += src->decoded_bytes;
+    dst->plain_bytes     += src->plain_bytes;
+    dst->grow_count      += src->grow_count;
+    if (src->largest_doc > dst->largest_doc) dst->largest_doc = src->largest_doc;
+    dst->time.tag_scan  += src->time.tag_scan;
+    dst->time.uu_bounds += src->time.uu_bounds;
+    dst->time.uu_size   += src->time.uu_size;
+    dst->time.decode    += src->time.decode;
+    dst->time.strip     += src->time.strip;
+    dst->time.grow      += src->time.grow;
+    dst->time.callback  += src->time.callback;
+}
+
+// ---------------------------------------------------------------------------
+// Streaming parse -- push chunks, documents are emitted at </DOCUMENT>
+//
+// The stream buffers input from the start of the document being built (or
+// from the last undecided '<' between documents). Everything before that is
+// dropped, so the buffer only ever holds about one document plus one chunk.
+// ---------------------------------------------------------------------------
+#define STREAM_INITIAL_CAP (64u * 1024u)
+
+static inline void span_shift(byte_span *s, const uint8_t *from, const uint8_t *to) {
+    if (s->ptr) s->ptr = to + (s->ptr - from);
+}
+
+// Move the pointers of the document under construction from one copy of the
+// buffered bytes to another. Both copies must still be valid.
+static void scanner_rebase(sgml_scanner *s, const uint8_t *from, const uint8_t *to) {
+    if (s->state == STATE_BETWEEN || s->state == STATE_SKIP) return;
+    span_shift(&s->cur.meta.type, from, to);
+    span_shift(&s->cur.meta.sequence, from, to);
+    span_shift(&s->cur.meta.filename, from, to);
+    span_shift(&s->cur.meta.description, from, to);
+    if (s->cur.content_start) s->cur.content_start = to + (s->cur.content_start - from);
+    if (s->text_start) s->text_start = to + (s->text_start - from);
+    if (s->text_end) s->text_end = to + (s->text_end - from);
+    s->doc_start = to + (s->doc_start - from);
+}
+
+static int stream_sink(void *ctx, document *doc) {
+    sgml_stream *st = (sgml_stream *)ctx;
+    sgml_scanner *sc = (sgml_scanner *)st->scanner;
+    INSTR_START(sc->stats, t0);
+    int ok = st->cb(st->user, doc);
+    INSTR_ADD(sc->stats, callback, t0);
+    sgml_mem_free(sc->opts.allocator, doc->decoded);
+    doc->decoded = NULL;
+    return ok;
+}
+
+// Make room for extra more bytes. Bytes nothing refers to anymore are dropped
+// first; the buffer only grows when the kept tail plus extra doesn't fit.
+static int stream_reserve(sgml_stream *st, size_t extra) {
+    if (st->len + extra <= st->cap) return 1;
+
+    sgml_scanner *sc = (sgml_scanner *)st->scanner;
+    // A skipped document needs none of its bytes kept
+    size_t keep = sc->state == STATE_BETWEEN || sc->state == STATE_SKIP
+                      ? st->scan_pos : (size_t)(sc->doc_start - st->buf);
+    size_t kept_len = st->len - keep;
+
+    if (kept_len + extra <= st->cap) {
+        scanner_rebase(sc, st->buf + keep, st->buf);
+        memmove(st->buf, st->buf + keep, kept_len);
+    } else {
+        size_t new_cap = st->cap ? st->cap * 2 : STREAM_INITIAL_CAP;
+        while (new_cap < kept_len + extra) new_cap *= 2;
+        INSTR_START(sc->stats, t0);
+        uint8_t *tmp = (uint8_t *)malloc(new_cap);
+        if (!tmp) return 0;
+        if (kept_len) memcpy(tmp, st->buf + keep, kept_len);
+        INSTR_ADD(sc->stats, grow, t0);
+        INSTR(if (sc->stats) sc->stats->grow_count++);
+        scanner_rebase(sc, st->buf + keep, tmp);
+        free(st->buf);
+        st->buf = tmp;
+        st->cap = new_cap;
+    }
+    st->len      = kept_len;
+    st->scan_pos -= keep;
+    return 1;
+}
+
+static sgml_status stream_scan(sgml_stream *st, int final) {
+    sgml_scanner *sc = (sgml_scanner *)st->scanner;
+    const uint8_t *stop = scan_tags_counted(sc, st->buf + st->scan_pos, st->buf + st->len,
+                                    final, stream_sink, st);
+    if (!stop) {
+        st->status = SGML_STATUS_ABORTED;
+        return st->status;
+    }
+    st->scan_pos = (size_t)(stop - st->buf);
+    if (sc->status != SGML_STATUS_OK && st->status == SGML_STATUS_OK)
+        st->status = sc->status;
+    return st->status;
+}
+
+int sgml_stream_init(sgml_stream *st, const sgml_parse_options *opts,
+                     sgml_document_cb cb, void *user, sgml_parse_stats *stats) {
+    memset(st, 0, sizeof(*st));
+    st->status = SGML_STATUS_OK;
+    st->cb     = cb;
+    st->user   = user;
+    sgml_scanner *sc = (sgml_scanner *)malloc(sizeof(sgml_scanner));
+    if (!sc) {
+        st->status = SGML_STATUS_OOM;
+        return 0;
+    }
+    scanner_init(sc, opts, stats);
+    st->scanner = sc;
+    return 1;
+}
+
+sgml_status sgml_stream_feed(sgml_stream *st, const uint8_t *chunk, size_t len) {
+    if (st->status == SGML_STATUS_OOM || st->status == SGML_STATUS_ABORTED) return st->status;
+    if (len == 0) return st->status;
+    if (!stream_reserve(st, len)) {
+        st->status = SGML_STATUS_OOM;
+        return st->status;
+    }
+    memcpy(st->buf + st->len, chunk, len);
+    st->len += len;
+    return stream_scan(st, 0);
+}
+
+sgml_status sgml_stream_finish(sgml_stream *st) {
+    if (st->status == SGML_STATUS_OOM || st->status == SGML_STATUS_ABORTED) return st->status;
+    return stream_scan(st, 1);
+}
+
+void sgml_stream_free(sgml_stream *st) {
+    if (!st) return;
+    sgml_scanner *sc = (sgml_scanner *)st->scanner;
+    if (sc) sgml_mem_free(sc->opts.allocator, sc->cur.decoded);
+    free(sc);
+    free(st->buf);
+    st->scanner = NULL;
+    st->buf     = NULL;
+    st->len     = 0;
+    st->cap     = 0;
+}
+
 // ---------------------------------------------------------------------------
 // Submission metadata (unchanged -- not hot path)
 // ---------------------------------------------------------------------------
@@ -403,7 +1009,9 @@ static int add_event(submission_metadata *m, submission_event_type type,
                      byte_span key, byte_span value, int depth) {
     if (m->count == m->cap) {
         size_t new_cap = m->cap ? m->cap * 2 : EVENTS_INITIAL_CAP;
-        submission_event *tmp = (submission_event *)realloc(m->events, new_cap * sizeof(submission_event));
+        submission_event *tmp = (submission_event *)sgml_mem_realloc(&m->alloc, m->events,
+                                                                     m->cap * sizeof(submission_event),
+                                                                     new_cap * sizeof(submission_event));
         if (!tmp) return 0;
         m->events = tmp;
         m->cap    = new_cap;
@@ -503,52 +1111,67 @@ static int parse_tab_metadata(submission_metadata *m, const uint8_t *buf, size_t
     return 1;
 }
 
-submission_metadata parse_submission_metadata(const uint8_t *buf, size_t len) {
-    submission_metadata m = {0};
-    m.status = SGML_STATUS_OK;
-
-    const uint8_t *doc_start = find_subspan(buf, len, DOC_OPEN, DOC_OPEN_LEN);
-    size_t sub_len = doc_start ? (size_t)(doc_start - buf) : len;
-    if (sub_len == 0) return m;
+// Header events from buf[0, sub_len), the bytes before the first <DOCUMENT>
+static sgml_status parse_header_region(submission_metadata *m, const uint8_t *buf, size_t sub_len) {
+    m->count  = 0;
+    m->status = SGML_STATUS_OK;
+    if (sub_len == 0) return m->status;
 
     byte_span sub = ltrim_span((byte_span){ buf, sub_len });
-    if (sub.len == 0) return m;
+    if (sub.len == 0) return m->status;
 
     if (sub.ptr[0] == '-') {
         size_t privacy_end = find_double_newline(sub.ptr, sub.len);
         if (privacy_end > 0 && privacy_end < sub.len) {
             byte_span key   = { (const uint8_t *)"PRIVACY-ENHANCED-MESSAGE", 24 };
             byte_span value = { sub.ptr, privacy_end };
-            if (!add_event(&m, SUB_EVENT_KEYVAL, key, value, 0)) {
-                m.status = SGML_STATUS_OOM;
-                return m;
+            if (!add_event(m, SUB_EVENT_KEYVAL, key, value, 0)) {
+                m->status = SGML_STATUS_OOM;
+                return m->status;
             }
             sub.ptr += privacy_end;
             sub.len -= privacy_end;
             sub = ltrim_span(sub);
         }
-        if (!parse_tab_metadata(&m, sub.ptr, sub.len)) {
-            m.status = SGML_STATUS_OOM;
-            return m;
+        if (!parse_tab_metadata(m, sub.ptr, sub.len)) {
+            m->status = SGML_STATUS_OOM;
+            return m->status;
         }
     } else if (sub.len >= 3 && memcmp(sub.ptr, "<SE", 3) == 0) {
-        if (!parse_tab_metadata(&m, sub.ptr, sub.len)) {
-            m.status = SGML_STATUS_OOM;
-            return m;
+        if (!parse_tab_metadata(m, sub.ptr, sub.len)) {
+            m->status = SGML_STATUS_OOM;
+            return m->status;
         }
     } else {
-        if (!parse_archive_metadata(&m, sub.ptr, sub.len)) {
-            m.status = SGML_STATUS_OOM;
-            return m;
+        if (!parse_archive_metadata(m, sub.ptr, sub.len)) {
+            m->status = SGML_STATUS_OOM;
+            return m->status;
         }
     }
 
+    return m->status;
+}
+
+sgml_status parse_submission_metadata_into(submission_metadata *m, const uint8_t *buf, size_t len) {
+    const uint8_t *doc_start = find_subspan(buf, len, DOC_OPEN, DOC_OPEN_LEN);
+    return parse_header_region(m, buf, doc_start ? (size_t)(doc_start - buf) : len);
+}
+
+submission_metadata parse_submission_metadata_ex(const uint8_t *buf, size_t len,
+                                                 const sgml_allocator *alloc) {
+    submission_metadata m = {0};
+    if (alloc) m.alloc = *alloc;
+    parse_submission_metadata_into(&m, buf, len);
     return m;
 }
 
+submission_metadata parse_submission_metadata(const uint8_t *buf, size_t len) {
+    return parse_submission_metadata_ex(buf, len, NULL);
+}
+
 void free_submission_metadata(submission_metadata *m) {
     if (!m) return;
-    free(m->events);
+    sgml_mem_free(&m->alloc, m->events);
     m->events = NULL;
     m->count  = 0;
     m->cap    = 0;
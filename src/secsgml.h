@@ -4,6 +4,8 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "sgml_alloc.h"
+
 // ---------------------------------------------------------------------------
 // Core span type -- a view into an existing buffer, no ownership
 // ---------------------------------------------------------------------------
@@ -34,7 +36,8 @@ typedef struct {
     const uint8_t *content_start;
     size_t         content_len;
 
-    // If uuencoded: malloc'd decoded output, caller must free
+    // If uuencoded: decoded output from the result's allocator, freed with it
+    // (NULL until sgml_decode_document when parsed with lazy_decode)
     // If not uuencoded: NULL, use content_start/content_len directly
     uint8_t *decoded;
     size_t   decoded_len;
@@ -48,7 +51,8 @@ typedef struct {
 typedef enum {
     SGML_STATUS_OK = 0,
     SGML_STATUS_OOM = 1,
-    SGML_STATUS_TRUNCATED = 2
+    SGML_STATUS_TRUNCATED = 2,
+    SGML_STATUS_ABORTED = 3
 } sgml_status;
 
 typedef struct {
@@ -56,14 +60,118 @@ typedef struct {
     size_t    doc_count;
     size_t    doc_cap;
     sgml_status status;
+    sgml_allocator alloc;  // owner of docs and decoded buffers
 } sgml_parse_result;
 
+// ---------------------------------------------------------------------------
+// Document filter -- decided at <TEXT>, once TYPE, SEQUENCE and FILENAME are
+// known. A rejected document is skipped to </DOCUMENT>: never decoded,
+// stripped, added to the result or passed to a stream callback.
+// ---------------------------------------------------------------------------
+
+// Return 0 to drop the document
+typedef int (*sgml_filter_fn)(void *user, const document_meta *meta);
+
+typedef struct {
+    // TYPE globs ('*' any run, '?' one byte), ASCII case-insensitive. A
+    // document is kept if it matches one of types (any if none are given)
+    // and none of exclude_types.
+    const char *const *types;
+    size_t             ntypes;
+    const char *const *exclude_types;
+    size_t             nexclude_types;
+    // FILENAME extensions to keep, without the dot, case-insensitive; none = any
+    const char *const *extensions;
+    size_t             nextensions;
+    // Keep SEQUENCE in [min_sequence, max_sequence]; 0 = unbounded. With
+    // either bound set, a document without a numeric SEQUENCE is dropped.
+    unsigned long      min_sequence;
+    unsigned long      max_sequence;
+    // Called after the checks above pass; NULL = keep
+    sgml_filter_fn     fn;
+    void              *user;
+} sgml_filter;
+
+// 1 if f keeps a document with this meta (f NULL keeps everything)
+int sgml_filter_match(const sgml_filter *f, const document_meta *meta);
+
+// ---------------------------------------------------------------------------
+// Parse options -- pass NULL for defaults
+// ---------------------------------------------------------------------------
+#define SGML_PARALLEL_DECODE_MIN (4u * 1024u * 1024u)
+
+typedef struct {
+    // Threads used to decode one large uuencoded document.
+    // 0 = one per core, 1 = always decode on the calling thread.
+    int    decode_threads;
+    // Encoded payloads smaller than this decode on the calling thread.
+    // 0 = SGML_PARALLEL_DECODE_MIN.
+    size_t parallel_decode_min;
+    // Record content_start/content_len of uuencoded documents without
+    // decoding them; decode later with sgml_decode_document(_into).
+    int    lazy_decode;
+    // Visit every tag candidate inside <TEXT> instead of jumping to the next
+    // </TEXT> or </DOCUMENT>. Same output; for benchmarking the skip.
+    int    no_text_skip;
+    // Allocator for the docs array and decoded buffers. NULL = malloc.
+    // Must outlive a stream; parse_sgml_into copies it into the result.
+    const sgml_allocator *allocator;
+    // Documents to keep, see sgml_filter. NULL = all. Must outlive a stream.
+    const sgml_filter    *filter;
+} sgml_parse_options;
+
+// Nanoseconds per parse stage. tag_scan is everything scan_tags does outside
+// the other stages. The fused decode finds the "end" line and sizes as it
+// decodes, so on that path bounds and sizing time is in decode; uu_size is
+// the parallel path's segment planning. grow is docs array, decode buffer
+// and stream buffer reallocation; callback is time in stream callbacks.
+typedef struct {
+    uint64_t tag_scan;
+    uint64_t uu_bounds;
+    uint64_t uu_size;
+    uint64_t decode;
+    uint64_t strip;
+    uint64_t grow;
+    uint64_t callback;
+} sgml_stage_times;
+
 typedef struct {
     // Counts
     size_t doc_count;
     size_t uuencoded_count;
+    size_t filtered_count;      // dropped by opts->filter, not in doc_count
+
+    // Filled only when the library is built with -DSECSGML_INSTRUMENT.
+    // Like the counts these accumulate across calls; zero the struct to
+    // start over.
+    uint64_t uuencoded_bytes;   // encoded payload bytes
+    uint64_t decoded_bytes;
+    uint64_t plain_bytes;       // plain document content after wrapper stripping
+    uint64_t largest_doc;       // largest <TEXT> body seen
+    uint64_t grow_count;        // reallocations counted in time.grow
+    sgml_stage_times time;
 } sgml_parse_stats;
 
+// ---------------------------------------------------------------------------
+// Streaming parse -- push-style, input arrives in chunks
+// ---------------------------------------------------------------------------
+// Called once per document as soon as its </DOCUMENT> is seen. Spans and
+// content_start point into the stream's internal buffer and are only valid
+// during the call. The stream frees doc->decoded (with opts->allocator) after
+// the call returns; set it to NULL to take ownership. Return 0 to stop parsing.
+typedef int (*sgml_document_cb)(void *user, document *doc);
+
+typedef struct {
+    uint8_t *buf;        // buffered input, from the oldest byte still needed
+    size_t   len;
+    size_t   cap;
+    size_t   scan_pos;   // offset in buf where the next scan resumes
+    void    *scanner;    // scanner state carried across chunks
+    sgml_document_cb cb;
+    void    *user;
+    sgml_status status;
+} sgml_stream;
+
 // ---------------------------------------------------------------------------
 // Submission metadata (before first <DOCUMENT>)
 // ---------------------------------------------------------------------------
@@ -85,6 +193,7 @@ typedef struct {
     size_t count;
     size_t cap;
     sgml_status status;
+    sgml_allocator alloc;  // owner of events
 } submission_metadata;
 
 // ---------------------------------------------------------------------------
@@ -92,7 +201,95 @@ typedef struct {
 // ---------------------------------------------------------------------------
 sgml_parse_result    parse_sgml(const uint8_t *buf, size_t len, sgml_parse_stats *stats);
 void                 free_sgml_parse_result(sgml_parse_result *r);
+
+// Streaming: init, feed any number of chunks of any size, then finish.
+// Peak memory is bounded by the largest document, not the whole input.
+int                  sgml_stream_init(sgml_stream *s, const sgml_parse_options *opts,
+                                      sgml_document_cb cb, void *user, sgml_parse_stats *stats);
+sgml_status          sgml_stream_feed(sgml_stream *s, const uint8_t *chunk, size_t len);
+sgml_status          sgml_stream_finish(sgml_stream *s);
+void                 sgml_stream_free(sgml_stream *s);
+
 submission_metadata  parse_submission_metadata(const uint8_t *buf, size_t len);
+submission_metadata  parse_submission_metadata_ex(const uint8_t *buf, size_t len,
+                                                  const sgml_allocator *alloc);
 void                 free_submission_metadata(submission_metadata *m);
 
+// Reuse variants for long-running workers: parse into an existing result,
+// keeping its arrays. reset frees decoded buffers but keeps the docs array.
+// parse_submission_metadata_into allocates from m->alloc. With an arena
+// allocator, resetting the arena releases everything at once: zero the
+// result structs (keeping alloc) instead of freeing them.
+sgml_status          parse_sgml_into(sgml_parse_result *r, const uint8_t *buf, size_t len,
+                                     const sgml_parse_options *opts, sgml_parse_stats *stats);
+void                 reset_sgml_parse_result(sgml_parse_result *r);
+sgml_status          parse_submission_metadata_into(submission_metadata *m, const uint8_t *buf, size_t len);
+
+// Header and documents in one pass: the tag scan hands the bytes before the
+// first <DOCUMENT> to the header parser when it gets there, so the header
+// region is read once instead of being searched by parse_submission_metadata
+// and rescanned by parse_sgml. Same results as calling both; m allocates
+// from m->alloc. Returns the first failure of the two (each struct keeps
+// its own status).
+sgml_status          parse_submission_into(sgml_parse_result *r, submission_metadata *m,
+                                           const uint8_t *buf, size_t len,
+                                           const sgml_parse_options *opts, sgml_parse_stats *stats);
+
+// ---------------------------------------------------------------------------
+// Document index -- where each document is, without decoding or copying it
+//
+// Offsets are from the start of the parsed buffer (the submission file), so
+// one document can later be read with a positioned read and decoded on its
+// own; see sgml_index.h for the sidecar file and the reader.
+// ---------------------------------------------------------------------------
+typedef struct {
+    document_meta meta;       // spans into the parsed buffer, or the loaded sidecar
+    uint64_t doc_offset;      // '<' of <DOCUMENT>
+    uint64_t text_offset;     // byte after <TEXT>; 0 if the document has none
+    uint64_t text_end;        // '<' of </TEXT>; 0 if the document has none
+    // Same span parse_sgml gives content_start/content_len: the encoded lines
+    // of a uuencoded document, the text without <PDF>/<XBRL>/<XML> otherwise
+    uint64_t content_offset;
+    uint64_t content_len;
+    uint64_t decoded_size;    // uudecode_size of the encoded lines; 0 if plain
+    int      is_uuencoded;
+} sgml_index_entry;
+
+typedef struct {
+    sgml_index_entry *docs;
+    size_t    doc_count;
+    size_t    doc_cap;
+    uint64_t  source_len;     // length of the parsed buffer
+    uint8_t  *backing;        // sidecar bytes the meta spans point into, if loaded
+    sgml_status status;
+    sgml_allocator alloc;     // owner of docs and backing
+} sgml_doc_index;
+
+// Scans buf like parse_sgml_into with lazy_decode, but keeps only the index:
+// no document is decoded and no docs array is built. Reuses ix->docs and
+// allocates from ix->alloc.
+sgml_status          parse_sgml_index_into(sgml_doc_index *ix, const uint8_t *buf, size_t len,
+                                           sgml_parse_stats *stats);
+// Header and index in one pass, as parse_submission_into is for the full
+// parse. m allocates from m->alloc. Returns the first failure of the two.
+sgml_status          parse_submission_index_into(sgml_doc_index *ix, submission_metadata *m,
+                                                 const uint8_t *buf, size_t len,
+                                                 sgml_parse_stats *stats);
+void                 free_sgml_doc_index(sgml_doc_index *ix);
+
+// On-demand decode of a uuencoded document parsed with lazy_decode. The input
+// it was parsed from must still be alive. sgml_decode_document fills
+// doc->decoded (freed with the result as usual) and does nothing if it is
+// already set; opts->allocator must match the one the result was parsed
+// with. sgml_decoded_size is the exact size _into needs; _into decodes
+// into a caller buffer and returns SGML_STATUS_TRUNCATED if it was too small.
+sgml_status          sgml_decode_document(document *doc, const sgml_parse_options *opts);
+size_t               sgml_decoded_size(const document *doc);
+sgml_status          sgml_decode_document_into(const document *doc, uint8_t *out, size_t out_cap,
+                                               size_t *out_len);
+
+// Adds src into dst (largest_doc takes the max), for aggregating per-worker
+// stats in batch mode
+void                 sgml_parse_stats_add(sgml_parse_stats *dst, const sgml_parse_stats *src);
+
 #endif
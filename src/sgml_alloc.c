@@ -0,0 +1,119 @@
+#include "sgml_alloc.h"
+
+#include <string.h>
+
+struct sgml_arena_block {
+    sgml_arena_block *next;
+    size_t            cap;
+    size_t            used;
+    // data follows, aligned to ARENA_ALIGN
+};
+
+#define ARENA_ALIGN 16
+#define ARENA_HDR   ((sizeof(sgml_arena_block) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+static inline uint8_t *block_data(sgml_arena_block *b) {
+    return (uint8_t *)b + ARENA_HDR;
+}
+
+static sgml_arena_block *block_new(size_t cap) {
+    sgml_arena_block *b = (sgml_arena_block *)malloc(ARENA_HDR + cap);
+    if (!b) return NULL;
+    b->next = NULL;
+    b->cap  = cap;
+    b->used = 0;
+    return b;
+}
+
+void sgml_arena_init(sgml_arena *a, size_t block_size) {
+    memset(a, 0, sizeof(*a));
+    a->block_size = block_size ? block_size : SGML_ARENA_BLOCK_MIN;
+}
+
+void sgml_arena_reset(sgml_arena *a) {
+    a->cur  = a->head;
+    a->last = NULL;
+    if (a->cur) a->cur->used = 0;
+}
+
+void sgml_arena_free(sgml_arena *a) {
+    sgml_arena_block *b = a->head;
+    while (b) {
+        sgml_arena_block *next = b->next;
+        free(b);
+        b = next;
+    }
+    a->head = a->cur = NULL;
+    a->last = NULL;
+}
+
+void *sgml_arena_alloc(sgml_arena *a, size_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if (size == 0) size = ARENA_ALIGN;
+
+    sgml_arena_block *b = a->cur;
+    if (!b || b->cap - b->used < size) {
+        // Blocks after cur are left over from before the last reset: reuse
+        // the next one if it is big enough, otherwise replace it with a
+        // bigger one, so the chain never grows past the high-water layout.
+        sgml_arena_block *next = b ? b->next : a->head;
+        if (next && next->cap >= size) {
+            b = next;
+        } else {
+            size_t cap = size > a->block_size ? size : a->block_size;
+            sgml_arena_block *nb = block_new(cap);
+            if (!nb) return NULL;
+            nb->next = next ? next->next : NULL;
+            free(next);
+            if (b) b->next = nb;
+            else   a->head = nb;
+            b = nb;
+        }
+        b->used = 0;
+        a->cur  = b;
+    }
+    void *p = block_data(b) + b->used;
+    b->used += size;
+    a->last = p;
+    return p;
+}
+
+// ---------------------------------------------------------------------------
+// sgml_allocator adapter
+// ---------------------------------------------------------------------------
+static void *arena_alloc_cb(void *ctx, size_t size) {
+    return sgml_arena_alloc((sgml_arena *)ctx, size);
+}
+
+static void *arena_realloc_cb(void *ctx, void *ptr, size_t old_size, size_t new_size) {
+    sgml_arena *a = (sgml_arena *)ctx;
+    if (!ptr) return sgml_arena_alloc(a, new_size);
+
+    // Most recent allocation: grow or shrink in place when the block has room
+    if (ptr == a->last) {
+        sgml_arena_block *b = a->cur;
+        size_t off  = (size_t)((uint8_t *)ptr - block_data(b));
+        size_t need = (new_size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+        if (b->cap - off >= need) {
+            b->used = off + need;
+            return ptr;
+        }
+    }
+    if (new_size <= old_size) return ptr;
+    void *p = sgml_arena_alloc(a, new_size);
+    if (p) memcpy(p, ptr, old_size);
+    return p;
+}
+
+static void arena_free_cb(void *ctx, void *ptr) {
+    sgml_arena *a = (sgml_arena *)ctx;
+    if (ptr && ptr == a->last) {
+        a->cur->used = (size_t)((uint8_t *)ptr - block_data(a->cur));
+        a->last = NULL;
+    }
+}
+
+sgml_allocator sgml_arena_allocator(sgml_arena *a) {
+    sgml_allocator al = { arena_alloc_cb, arena_realloc_cb, arena_free_cb, a };
+    return al;
+}
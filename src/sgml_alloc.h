@@ -0,0 +1,65 @@
+#ifndef SGML_ALLOC_H
+#define SGML_ALLOC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// ---------------------------------------------------------------------------
+// Allocator hook
+//
+// Everything a parse result owns (docs array, decoded buffers, event arrays,
+// the standardized key/value arena) goes through one of these. A zeroed
+// sgml_allocator, or a NULL pointer where one is taken, means malloc.
+// realloc gets the old size so bump allocators can copy without headers.
+// ---------------------------------------------------------------------------
+typedef struct {
+    void *(*alloc)(void *ctx, size_t size);
+    void *(*realloc)(void *ctx, void *ptr, size_t old_size, size_t new_size);
+    void  (*free)(void *ctx, void *ptr);
+    void  *ctx;
+} sgml_allocator;
+
+static inline void *sgml_mem_alloc(const sgml_allocator *a, size_t size) {
+    return a && a->alloc ? a->alloc(a->ctx, size) : malloc(size);
+}
+
+static inline void *sgml_mem_realloc(const sgml_allocator *a, void *ptr,
+                                     size_t old_size, size_t new_size) {
+    if (a && a->alloc) return a->realloc(a->ctx, ptr, old_size, new_size);
+    return realloc(ptr, new_size);
+}
+
+static inline void sgml_mem_free(const sgml_allocator *a, void *ptr) {
+    if (!ptr) return;
+    if (a && a->alloc) a->free(a->ctx, ptr);
+    else free(ptr);
+}
+
+// ---------------------------------------------------------------------------
+// Bump arena
+//
+// Allocations are carved from a chain of blocks and never freed one by one
+// (freeing or growing the most recent allocation is done in place).
+// sgml_arena_reset makes every block reusable in O(1); blocks are kept until
+// sgml_arena_free. One arena per request, reset between filings, means the
+// steady state does no malloc at all.
+// ---------------------------------------------------------------------------
+#define SGML_ARENA_BLOCK_MIN (64u * 1024u)
+
+typedef struct sgml_arena_block sgml_arena_block;
+
+typedef struct {
+    sgml_arena_block *head;       // first block
+    sgml_arena_block *cur;        // block allocations come from
+    size_t            block_size; // default size of new blocks
+    void             *last;       // most recent allocation, for in-place realloc/free
+} sgml_arena;
+
+void           sgml_arena_init(sgml_arena *a, size_t block_size);  // 0 = SGML_ARENA_BLOCK_MIN
+void           sgml_arena_reset(sgml_arena *a);
+void           sgml_arena_free(sgml_arena *a);
+void          *sgml_arena_alloc(sgml_arena *a, size_t size);
+sgml_allocator sgml_arena_allocator(sgml_arena *a);
+
+#endif
@@ -0,0 +1,143 @@
+#include "sgml_file.h"
+
+#include <string.h>
+#include <errno.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+int sgml_file_open(sgml_file *f, const char *path) {
+    memset(f, 0, sizeof(*f));
+    HANDLE h = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+    if (h == INVALID_HANDLE_VALUE) return -1;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(h, &size)) {
+        CloseHandle(h);
+        return -1;
+    }
+    FILETIME written;
+    if (GetFileTime(h, NULL, NULL, &written)) {
+        // 100 ns ticks since 1601
+        uint64_t ticks = ((uint64_t)written.dwHighDateTime << 32) | written.dwLowDateTime;
+        f->mtime_ns = (int64_t)(ticks * 100u);
+    }
+    f->handle = h;
+    f->size   = (uint64_t)size.QuadPart;
+    return 0;
+}
+
+void sgml_file_close(sgml_file *f) {
+    if (f->handle && f->handle != INVALID_HANDLE_VALUE) CloseHandle(f->handle);
+    f->handle = NULL;
+}
+
+int64_t sgml_file_pread(const sgml_file *f, void *buf, size_t len, uint64_t offset) {
+    size_t done = 0;
+    while (done < len) {
+        DWORD want = len - done > 0x40000000u ? 0x40000000u : (DWORD)(len - done);
+        OVERLAPPED ov;
+        memset(&ov, 0, sizeof(ov));
+        ov.Offset     = (DWORD)(offset + done);
+        ov.OffsetHigh = (DWORD)((offset + done) >> 32);
+        DWORD got = 0;
+        if (!ReadFile(f->handle, (uint8_t *)buf + done, want, &got, &ov)) {
+            if (GetLastError() == ERROR_HANDLE_EOF) break;
+            return -1;
+        }
+        if (got == 0) break;
+        done += got;
+    }
+    return (int64_t)done;
+}
+#else
+int sgml_file_open(sgml_file *f, const char *path) {
+    memset(f, 0, sizeof(*f));
+    f->fd = open(path, O_RDONLY);
+    if (f->fd < 0) return -1;
+    struct stat st;
+    if (fstat(f->fd, &st) != 0) {
+        close(f->fd);
+        f->fd = -1;
+        return -1;
+    }
+    f->size = (uint64_t)st.st_size;
+#if defined(__APPLE__)
+    f->mtime_ns = (int64_t)st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    f->mtime_ns = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    return 0;
+}
+
+void sgml_file_close(sgml_file *f) {
+    if (f->fd >= 0) close(f->fd);
+    f->fd = -1;
+}
+
+int64_t sgml_file_pread(const sgml_file *f, void *buf, size_t len, uint64_t offset) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t got = pread(f->fd, (uint8_t *)buf + done, len - done, (off_t)(offset + done));
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (got == 0) break;
+        done += (size_t)got;
+    }
+    return (int64_t)done;
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// Identity -- size, mtime and a hash of sampled blocks
+// ---------------------------------------------------------------------------
+static uint64_t hash_mix(uint64_t h, uint64_t v) {
+    h ^= v;
+    h *= 0x9E3779B97F4A7C15ull;
+    return h ^ (h >> 29);
+}
+
+static uint64_t hash_bytes(uint64_t h, const uint8_t *p, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t v;
+        memcpy(&v, p + i, 8);
+        h = hash_mix(h, v);
+    }
+    uint64_t tail = 0;
+    for (size_t k = 0; i < n; i++, k++) tail |= (uint64_t)p[i] << (8 * k);
+    return hash_mix(h, tail ^ (uint64_t)n << 56);
+}
+
+int sgml_file_identify(const sgml_file *f, sgml_file_id *id) {
+    uint8_t block[SGML_FILE_SAMPLE_SIZE];
+    uint64_t h = hash_mix(0xCBF29CE484222325ull, f->size);
+    uint64_t span = (uint64_t)SGML_FILE_SAMPLES * SGML_FILE_SAMPLE_SIZE;
+    if (f->size <= span) {
+        for (uint64_t off = 0; off < f->size; off += SGML_FILE_SAMPLE_SIZE) {
+            int64_t got = sgml_file_pread(f, block, SGML_FILE_SAMPLE_SIZE, off);
+            if (got < 0) return -1;
+            h = hash_bytes(h, block, (size_t)got);
+        }
+    } else {
+        // Block k starts at k/(SAMPLES-1) of the way to the last block
+        uint64_t last = f->size - SGML_FILE_SAMPLE_SIZE;
+        for (uint64_t k = 0; k < SGML_FILE_SAMPLES; k++) {
+            uint64_t off = last / (SGML_FILE_SAMPLES - 1) * k;
+            if (k == SGML_FILE_SAMPLES - 1) off = last;
+            int64_t got = sgml_file_pread(f, block, SGML_FILE_SAMPLE_SIZE, off);
+            if (got < 0) return -1;
+            h = hash_bytes(h, block, (size_t)got);
+        }
+    }
+    id->size         = f->size;
+    id->mtime_ns     = f->mtime_ns;
+    id->content_hash = h;
+    return 0;
+}
@@ -0,0 +1,50 @@
+#ifndef SGML_FILE_H
+#define SGML_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// ---------------------------------------------------------------------------
+// Positioned reads -- for reading part of a submission (the header, one
+// document) without loading or mapping the whole file
+// ---------------------------------------------------------------------------
+typedef struct {
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    int    fd;
+#endif
+    uint64_t size;      // at open
+    int64_t  mtime_ns;  // last modification, at open
+} sgml_file;
+
+// 0, or -1 if path can't be opened
+int  sgml_file_open(sgml_file *f, const char *path);
+void sgml_file_close(sgml_file *f);
+
+// Reads len bytes at offset into buf (pread; ReadFile at an offset on
+// Windows). Fewer only at end of file. Returns the count, or -1 on error.
+int64_t sgml_file_pread(const sgml_file *f, void *buf, size_t len, uint64_t offset);
+
+// Identity of a file's contents for cache validation: size and mtime at
+// open, plus a hash of the size and up to SGML_FILE_SAMPLES blocks of
+// SGML_FILE_SAMPLE_SIZE bytes (the first, the last and evenly spaced ones
+// between; the whole file when it is smaller). Cheap to recompute on every
+// lookup, and catches a file rewritten within the mtime granularity.
+#define SGML_FILE_SAMPLES     16
+#define SGML_FILE_SAMPLE_SIZE 4096u
+
+typedef struct {
+    uint64_t size;
+    int64_t  mtime_ns;
+    uint64_t content_hash;
+} sgml_file_id;
+
+// 0, or -1 on a read error
+int  sgml_file_identify(const sgml_file *f, sgml_file_id *id);
+
+#endif
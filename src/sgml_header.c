@@ -0,0 +1,70 @@
+#include "sgml_header.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "sgml_file.h"
+
+static const char DOC_OPEN[] = "<DOCUMENT>";
+#define DOC_OPEN_LEN (sizeof(DOC_OPEN) - 1)
+
+// First <DOCUMENT> in buf[from, len), or len
+static size_t find_doc_open(const uint8_t *buf, size_t from, size_t len) {
+    const uint8_t *p = buf + from, *end = buf + len;
+    while ((p = (const uint8_t *)memchr(p, '<', (size_t)(end - p))) != NULL) {
+        if ((size_t)(end - p) < DOC_OPEN_LEN) break;
+        if (memcmp(p, DOC_OPEN, DOC_OPEN_LEN) == 0) return (size_t)(p - buf);
+        p++;
+    }
+    return len;
+}
+
+int sgml_read_header(const char *path, sgml_header *h) {
+    h->len = h->bytes_read = 0;
+    h->meta.count  = 0;
+    h->meta.status = SGML_STATUS_OK;
+
+    sgml_file f;
+    if (sgml_file_open(&f, path) != 0) return -1;
+
+    size_t chunk = SGML_HEADER_CHUNK;
+    size_t header_len = 0;
+    int found = 0;
+    while (!found) {
+        if (h->bytes_read + chunk > h->cap) {
+            size_t cap = h->bytes_read + chunk;
+            uint8_t *tmp = (uint8_t *)realloc(h->buf, cap);
+            if (!tmp) {
+                sgml_file_close(&f);
+                return -1;
+            }
+            h->buf = tmp;
+            h->cap = cap;
+        }
+        int64_t got = sgml_file_pread(&f, h->buf + h->bytes_read, chunk, h->bytes_read);
+        if (got < 0) {
+            sgml_file_close(&f);
+            return -1;
+        }
+        // A tag cut by the previous chunk boundary is searched again whole
+        size_t from = h->bytes_read >= DOC_OPEN_LEN - 1 ? h->bytes_read - (DOC_OPEN_LEN - 1) : 0;
+        h->bytes_read += (size_t)got;
+        header_len = find_doc_open(h->buf, from, h->bytes_read);
+        found = header_len < h->bytes_read;
+        if ((size_t)got < chunk) break;  // end of file
+        chunk *= 2;
+    }
+    sgml_file_close(&f);
+
+    h->len = header_len;
+    if (parse_submission_metadata_into(&h->meta, h->buf, h->len) != SGML_STATUS_OK) return -1;
+    return 0;
+}
+
+void sgml_header_free(sgml_header *h) {
+    if (!h) return;
+    free(h->buf);
+    free_submission_metadata(&h->meta);
+    h->buf = NULL;
+    h->cap = h->len = h->bytes_read = 0;
+}
@@ -0,0 +1,33 @@
+#ifndef SGML_HEADER_H
+#define SGML_HEADER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "secsgml.h"
+
+// ---------------------------------------------------------------------------
+// Header-only read -- submission metadata without loading the documents
+//
+// Reads the file from the start in chunks that double from
+// SGML_HEADER_CHUNK and stops at the first chunk containing <DOCUMENT>, so
+// a multi-GB submission costs a few KB of I/O. For indexing jobs that only
+// need CIK, form type, dates and accession number.
+// ---------------------------------------------------------------------------
+#define SGML_HEADER_CHUNK (16u * 1024u)
+
+typedef struct {
+    uint8_t *buf;        // bytes read; meta spans point into it
+    size_t   cap;
+    size_t   len;        // header bytes: up to the first <DOCUMENT>, or the whole file
+    size_t   bytes_read; // from the file, including the chunk tail past len
+    submission_metadata meta;  // allocates from meta.alloc
+} sgml_header;
+
+// Reads and parses the header of path into h. Zero h before the first call
+// (setting h->meta.alloc if wanted); later calls reuse buf. Returns 0, or
+// -1 if the file can't be opened or read or memory runs out.
+int  sgml_read_header(const char *path, sgml_header *h);
+void sgml_header_free(sgml_header *h);
+
+#endif
@@ -0,0 +1,394 @@
+#include "sgml_index.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#define SIDECAR_PATH_CAP 1024
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static void put_u64(uint8_t *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+static uint64_t get_u64(const uint8_t *p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+// Entry strings in file order
+static const size_t META_FIELDS[4] = {
+    offsetof(document_meta, type),
+    offsetof(document_meta, sequence),
+    offsetof(document_meta, filename),
+    offsetof(document_meta, description),
+};
+
+#define META_FIELD(meta, k) ((byte_span *)((uint8_t *)(meta) + META_FIELDS[k]))
+#define META_FIELD_CONST(meta, k) ((const byte_span *)((const uint8_t *)(meta) + META_FIELDS[k]))
+
+// ---------------------------------------------------------------------------
+// Serialize -- the whole sidecar in one buffer from alloc
+// ---------------------------------------------------------------------------
+
+// Appends s to the string table and records where it went
+static void put_string(uint8_t *field, uint8_t *str, uint32_t *pos, byte_span s) {
+    put_u32(field, *pos);
+    put_u32(field + 4, (uint32_t)s.len);
+    if (s.len) memcpy(str + *pos, s.ptr, s.len);
+    *pos += (uint32_t)s.len;
+}
+
+static uint8_t *sidecar_serialize(const sgml_sidecar *s, const sgml_allocator *alloc, size_t *out_len) {
+    const sgml_doc_index *ix = &s->index;
+    const submission_metadata *m = &s->header;
+    uint64_t strings_len = s->source.len;
+    for (size_t i = 0; i < ix->doc_count; i++) {
+        for (int k = 0; k < 4; k++) strings_len += META_FIELD_CONST(&ix->docs[i].meta, k)->len;
+    }
+    for (size_t i = 0; i < m->count; i++) strings_len += m->events[i].key.len + m->events[i].value.len;
+    if (ix->doc_count > UINT32_MAX || m->count > UINT32_MAX || strings_len > UINT32_MAX) return NULL;
+
+    uint64_t events_off  = SGML_INDEX_HEADER_SIZE + (uint64_t)ix->doc_count * SGML_INDEX_ENTRY_SIZE;
+    uint64_t strings_off = events_off + (uint64_t)m->count * SGML_INDEX_EVENT_SIZE;
+    size_t total = (size_t)(strings_off + strings_len);
+    uint8_t *buf = (uint8_t *)sgml_mem_alloc(alloc, total);
+    if (!buf) return NULL;
+    memset(buf, 0, (size_t)strings_off);
+
+    uint8_t *str = buf + strings_off;
+    uint32_t str_pos = 0;
+    memcpy(buf, SGML_INDEX_MAGIC, 8);
+    put_u32(buf + 8, SGML_INDEX_VERSION);
+    put_u32(buf + 12, (uint32_t)ix->doc_count);
+    put_u64(buf + 16, s->id.size);
+    put_u64(buf + 24, (uint64_t)s->id.mtime_ns);
+    put_u64(buf + 32, s->id.content_hash);
+    put_u64(buf + 40, strings_off);
+    put_u64(buf + 48, strings_len);
+    put_u32(buf + 56, (uint32_t)m->count);
+    put_string(buf + 60, str, &str_pos, s->source);
+    put_u32(buf + 68, 0);
+    put_u64(buf + 72, events_off);
+
+    for (size_t i = 0; i < ix->doc_count; i++) {
+        const sgml_index_entry *e = &ix->docs[i];
+        uint8_t *ent = buf + SGML_INDEX_HEADER_SIZE + i * SGML_INDEX_ENTRY_SIZE;
+        put_u64(ent, e->doc_offset);
+        put_u64(ent + 8, e->text_offset);
+        put_u64(ent + 16, e->text_end);
+        put_u64(ent + 24, e->content_offset);
+        put_u64(ent + 32, e->content_len);
+        put_u64(ent + 40, e->decoded_size);
+        put_u32(ent + 48, e->is_uuencoded ? SGML_INDEX_UUENCODED : 0);
+        for (int k = 0; k < 4; k++) put_string(ent + 56 + 8 * k, str, &str_pos, *META_FIELD_CONST(&e->meta, k));
+    }
+    for (size_t i = 0; i < m->count; i++) {
+        const submission_event *ev = &m->events[i];
+        uint8_t *p = buf + events_off + i * SGML_INDEX_EVENT_SIZE;
+        put_u32(p, (uint32_t)ev->type);
+        put_u32(p + 4, (uint32_t)ev->depth);
+        put_string(p + 8, str, &str_pos, ev->key);
+        put_string(p + 16, str, &str_pos, ev->value);
+    }
+    *out_len = total;
+    return buf;
+}
+
+// ---------------------------------------------------------------------------
+// Parse -- fills s from a sidecar in memory; spans point into buf
+// ---------------------------------------------------------------------------
+
+// String table span at field, 0 if out of bounds
+static int get_string(const uint8_t *field, const uint8_t *str, uint64_t str_len, byte_span *out) {
+    uint64_t off = get_u32(field), n = get_u32(field + 4);
+    if (off > str_len || n > str_len - off) return 0;
+    out->ptr = n ? str + off : NULL;
+    out->len = (size_t)n;
+    return 1;
+}
+
+static int sidecar_parse(sgml_sidecar *s, const uint8_t *buf, size_t len) {
+    sgml_doc_index *ix = &s->index;
+    submission_metadata *m = &s->header;
+    if (len < SGML_INDEX_HEADER_SIZE) return -1;
+    if (memcmp(buf, SGML_INDEX_MAGIC, 8) != 0) return -1;
+    if (get_u32(buf + 8) != SGML_INDEX_VERSION) return -1;
+
+    uint64_t count       = get_u32(buf + 12);
+    uint64_t strings_off = get_u64(buf + 40);
+    uint64_t strings_len = get_u64(buf + 48);
+    uint64_t events      = get_u32(buf + 56);
+    uint64_t events_off  = get_u64(buf + 72);
+    if (count > (len - SGML_INDEX_HEADER_SIZE) / SGML_INDEX_ENTRY_SIZE) return -1;
+    if (events_off < SGML_INDEX_HEADER_SIZE + count * SGML_INDEX_ENTRY_SIZE) return -1;
+    if (events_off > len || events > (len - events_off) / SGML_INDEX_EVENT_SIZE) return -1;
+    if (strings_off < events_off + events * SGML_INDEX_EVENT_SIZE) return -1;
+    if (strings_off > len || strings_len > len - strings_off) return -1;
+
+    const uint8_t *str = buf + strings_off;
+    s->id.size         = get_u64(buf + 16);
+    s->id.mtime_ns     = (int64_t)get_u64(buf + 24);
+    s->id.content_hash = get_u64(buf + 32);
+    if (!get_string(buf + 60, str, strings_len, &s->source)) return -1;
+
+    if (count > ix->doc_cap) {
+        sgml_index_entry *tmp = (sgml_index_entry *)sgml_mem_realloc(
+            &ix->alloc, ix->docs, ix->doc_cap * sizeof(sgml_index_entry),
+            (size_t)count * sizeof(sgml_index_entry));
+        if (!tmp) return -1;
+        ix->docs    = tmp;
+        ix->doc_cap = (size_t)count;
+    }
+    for (uint64_t i = 0; i < count; i++) {
+        const uint8_t *ent = buf + SGML_INDEX_HEADER_SIZE + i * SGML_INDEX_ENTRY_SIZE;
+        sgml_index_entry *e = &ix->docs[i];
+        memset(e, 0, sizeof(*e));
+        e->doc_offset     = get_u64(ent);
+        e->text_offset    = get_u64(ent + 8);
+        e->text_end       = get_u64(ent + 16);
+        e->content_offset = get_u64(ent + 24);
+        e->content_len    = get_u64(ent + 32);
+        e->decoded_size   = get_u64(ent + 40);
+        e->is_uuencoded   = (get_u32(ent + 48) & SGML_INDEX_UUENCODED) != 0;
+        if (e->content_offset > s->id.size || e->content_len > s->id.size - e->content_offset)
+            return -1;
+        for (int k = 0; k < 4; k++) {
+            if (!get_string(ent + 56 + 8 * k, str, strings_len, META_FIELD(&e->meta, k))) return -1;
+        }
+    }
+
+    if (events > m->cap) {
+        submission_event *tmp = (submission_event *)sgml_mem_realloc(
+            &m->alloc, m->events, m->cap * sizeof(submission_event),
+            (size_t)events * sizeof(submission_event));
+        if (!tmp) return -1;
+        m->events = tmp;
+        m->cap    = (size_t)events;
+    }
+    for (uint64_t i = 0; i < events; i++) {
+        const uint8_t *p = buf + events_off + i * SGML_INDEX_EVENT_SIZE;
+        submission_event *ev = &m->events[i];
+        ev->type  = (submission_event_type)get_u32(p);
+        ev->depth = (int)get_u32(p + 4);
+        if (!get_string(p + 8, str, strings_len, &ev->key)) return -1;
+        if (!get_string(p + 16, str, strings_len, &ev->value)) return -1;
+    }
+
+    ix->doc_count  = (size_t)count;
+    ix->source_len = s->id.size;
+    ix->status     = SGML_STATUS_OK;
+    m->count       = (size_t)events;
+    m->status      = SGML_STATUS_OK;
+    return 0;
+}
+
+// Makes buf (from s->index.alloc) the backing of s, or frees it on failure
+static int sidecar_adopt(sgml_sidecar *s, uint8_t *buf, size_t len) {
+    sgml_doc_index *ix = &s->index;
+    if (sidecar_parse(s, buf, len) != 0) {
+        sgml_mem_free(&ix->alloc, buf);
+        ix->doc_count  = 0;
+        s->header.count = 0;
+        return -1;
+    }
+    sgml_mem_free(&ix->alloc, ix->backing);
+    ix->backing = buf;
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Writer and loader
+// ---------------------------------------------------------------------------
+static int write_atomic(const char *path, const uint8_t *buf, size_t len) {
+    char tmp[SIDECAR_PATH_CAP + 32];
+#ifdef _WIN32
+    unsigned long pid = (unsigned long)GetCurrentProcessId();
+#else
+    unsigned long pid = (unsigned long)getpid();
+#endif
+    if ((size_t)snprintf(tmp, sizeof(tmp), "%s.%lu.tmp", path, pid) >= sizeof(tmp)) return -1;
+    FILE *f = fopen(tmp, "wb");
+    if (!f) return -1;
+    int ok = fwrite(buf, 1, len, f) == len;
+    if (fclose(f) != 0) ok = 0;
+#ifdef _WIN32
+    if (ok) ok = MoveFileExA(tmp, path, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    if (ok) ok = rename(tmp, path) == 0;
+#endif
+    if (!ok) remove(tmp);
+    return ok ? 0 : -1;
+}
+
+int sgml_index_write(const char *path, const sgml_sidecar *s) {
+    size_t len = 0;
+    uint8_t *buf = sidecar_serialize(s, NULL, &len);
+    if (!buf) return -1;
+    int w = write_atomic(path, buf, len);
+    free(buf);
+    return w;
+}
+
+int sgml_index_load(const char *path, sgml_sidecar *s) {
+    s->index.doc_count = 0;
+    s->header.count    = 0;
+    sgml_file f;
+    if (sgml_file_open(&f, path) != 0) return -1;
+    size_t len = (size_t)f.size;
+    uint8_t *buf = (uint8_t *)sgml_mem_alloc(&s->index.alloc, len ? len : 1);
+    int ok = buf && sgml_file_pread(&f, buf, len, 0) == (int64_t)len;
+    sgml_file_close(&f);
+    if (!ok) {
+        sgml_mem_free(&s->index.alloc, buf);
+        return -1;
+    }
+    return sidecar_adopt(s, buf, len);
+}
+
+void sgml_sidecar_free(sgml_sidecar *s) {
+    if (!s) return;
+    free_sgml_doc_index(&s->index);
+    free_submission_metadata(&s->header);
+    s->source = (byte_span){0};
+}
+
+// ---------------------------------------------------------------------------
+// Cache -- sidecar when the file is unchanged, one parse otherwise
+// ---------------------------------------------------------------------------
+static int sidecar_path(char *out, size_t cap, const char *cache_dir, const char *path) {
+    int n;
+    if (!cache_dir) {
+        n = snprintf(out, cap, "%s.sgmlidx", path);
+    } else {
+        // FNV-1a of the path
+        uint64_t h = 0xCBF29CE484222325ull;
+        for (const char *p = path; *p; p++) h = (h ^ (uint8_t)*p) * 0x100000001B3ull;
+        n = snprintf(out, cap, "%s/%016llx.sgmlidx", cache_dir, (unsigned long long)h);
+    }
+    return n >= 0 && (size_t)n < cap;
+}
+
+static int sidecar_matches(const sgml_sidecar *s, const sgml_file_id *id, const char *path) {
+    size_t path_len = strlen(path);
+    return s->id.size == id->size && s->id.mtime_ns == id->mtime_ns &&
+           s->id.content_hash == id->content_hash && s->source.len == path_len &&
+           memcmp(s->source.ptr, path, path_len) == 0;
+}
+
+// Parses the submission in f, identified as id, and replaces s with the
+// sidecar built from it; stores it at store_path too if given (best effort)
+static int build_sidecar(sgml_sidecar *s, const sgml_file *f, const sgml_file_id *id,
+                         const char *path, const char *store_path, sgml_parse_stats *stats) {
+    size_t len = (size_t)f->size;
+    uint8_t *buf = (uint8_t *)malloc(len ? len : 1);
+    if (!buf) return -1;
+    if (sgml_file_pread(f, buf, len, 0) != (int64_t)len) {
+        free(buf);
+        return -1;
+    }
+    if (parse_submission_index_into(&s->index, &s->header, buf, len, stats) == SGML_STATUS_OOM) {
+        free(buf);
+        return -1;
+    }
+    s->id     = *id;
+    s->source = (byte_span){ (const uint8_t *)path, strlen(path) };
+
+    size_t side_len = 0;
+    uint8_t *side = sidecar_serialize(s, &s->index.alloc, &side_len);
+    free(buf);
+    if (!side) return -1;
+    if (store_path) write_atomic(store_path, side, side_len);
+    // Spans now point into the sidecar bytes instead of the submission
+    return sidecar_adopt(s, side, side_len);
+}
+
+int sgml_index_build(sgml_sidecar *s, const sgml_file *f, const char *path, sgml_parse_stats *stats) {
+    sgml_file_id id;
+    if (sgml_file_identify(f, &id) != 0) return -1;
+    return build_sidecar(s, f, &id, path, NULL, stats);
+}
+
+int sgml_index_cache_get(const char *cache_dir, const char *path, sgml_sidecar *s,
+                         sgml_file *f, int *hit) {
+    *hit = 0;
+    if (sgml_file_open(f, path) != 0) return -1;
+    sgml_file_id id;
+    if (sgml_file_identify(f, &id) != 0) {
+        sgml_file_close(f);
+        return -1;
+    }
+    char side[SIDECAR_PATH_CAP];
+    int have_path = sidecar_path(side, sizeof(side), cache_dir, path);
+    if (have_path && sgml_index_load(side, s) == 0 && sidecar_matches(s, &id, path)) {
+        *hit = 1;
+        return 0;
+    }
+    if (build_sidecar(s, f, &id, path, have_path ? side : NULL, NULL) != 0) {
+        sgml_file_close(f);
+        return -1;
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// One document by positioned read
+// ---------------------------------------------------------------------------
+static int span_is(byte_span s, const char *name, size_t name_len) {
+    return s.len == name_len && (name_len == 0 || memcmp(s.ptr, name, name_len) == 0);
+}
+
+const sgml_index_entry *sgml_index_find(const sgml_doc_index *ix, const char *name, size_t name_len) {
+    for (size_t i = 0; i < ix->doc_count; i++) {
+        const sgml_index_entry *e = &ix->docs[i];
+        if (span_is(e->meta.type, name, name_len) || span_is(e->meta.filename, name, name_len)) return e;
+    }
+    return NULL;
+}
+
+size_t sgml_index_document_size(const sgml_index_entry *e) {
+    return (size_t)(e->is_uuencoded ? e->decoded_size : e->content_len);
+}
+
+int sgml_index_read_document(const sgml_file *f, const sgml_index_entry *e,
+                             uint8_t *out, size_t out_cap, size_t *out_len) {
+    *out_len = 0;
+    if (out_cap < sgml_index_document_size(e)) return -1;
+    size_t n = (size_t)e->content_len;
+    if (!e->is_uuencoded) {
+        if (sgml_file_pread(f, out, n, e->content_offset) != (int64_t)n) return -1;
+        *out_len = n;
+        return 0;
+    }
+
+    uint8_t *enc = (uint8_t *)malloc(n ? n : 1);
+    if (!enc) return -1;
+    int ok = sgml_file_pread(f, enc, n, e->content_offset) == (int64_t)n;
+    if (ok) {
+        document doc = {0};
+        doc.content_start = enc;
+        doc.content_len   = n;
+        doc.is_uuencoded  = 1;
+        // TRUNCATED only past the decode cap, where parse_sgml truncates too
+        ok = sgml_decode_document_into(&doc, out, out_cap, out_len) != SGML_STATUS_OOM;
+    }
+    free(enc);
+    return ok ? 0 : -1;
+}
@@ -0,0 +1,94 @@
+#ifndef SGML_INDEX_H
+#define SGML_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "secsgml.h"
+#include "sgml_file.h"
+
+// ---------------------------------------------------------------------------
+// Index sidecar -- a parse_sgml_index_into result on disk
+//
+// Small enough to keep next to every submission: one fixed-size entry per
+// document, the header events, and their strings. With it, one exhibit is
+// one positioned read of its content span (and a decode if uuencoded)
+// instead of a parse of the whole file. All integers are little-endian.
+//
+//   header   magic "SGMLIDX2", u32 version, u32 document count,
+//            u64 source size, i64 source mtime (ns), u64 source content hash,
+//            u64 string table offset, u64 string table length,
+//            u32 event count, u32 source path offset, u32 source path length,
+//            u32 reserved, u64 events offset
+//   entries  document count x { u64 doc offset, u64 text offset, u64 text end,
+//                               u64 content offset, u64 content length,
+//                               u64 decoded size, u32 flags, u32 reserved,
+//                               4 x { u32 string offset, u32 string length } }
+//   events   event count x { u32 type, u32 depth, u32 key offset, u32 key length,
+//                            u32 value offset, u32 value length }
+//   strings  source path, TYPE, SEQUENCE, FILENAME, DESCRIPTION values and
+//            header keys and values, not terminated
+//
+// Source size, mtime and content hash are the sgml_file_id of the indexed
+// file; sgml_index_cache_get only trusts a sidecar whose identity and path
+// still match.
+// ---------------------------------------------------------------------------
+#define SGML_INDEX_MAGIC       "SGMLIDX2"
+#define SGML_INDEX_VERSION     2
+#define SGML_INDEX_HEADER_SIZE 80
+#define SGML_INDEX_ENTRY_SIZE  88
+#define SGML_INDEX_EVENT_SIZE  24
+
+// Entry flags
+#define SGML_INDEX_UUENCODED   1u
+
+typedef struct {
+    sgml_doc_index      index;
+    submission_metadata header;  // allocates from header.alloc
+    sgml_file_id        id;      // of the indexed file
+    byte_span           source;  // its path
+} sgml_sidecar;
+
+// Writes s to path through a temporary file and a rename, so readers never
+// see a partial sidecar. Returns 0, or -1 if it can't be written.
+int    sgml_index_write(const char *path, const sgml_sidecar *s);
+
+// Loads a sidecar into s, reusing its arrays. Meta, event and source spans
+// point into s->index.backing. Returns 0, or -1 if it can't be read or is
+// not a valid sidecar (bad magic or version, anything out of bounds).
+int    sgml_index_load(const char *path, sgml_sidecar *s);
+void   sgml_sidecar_free(sgml_sidecar *s);
+
+// Sidecar for the submission open in f, opened from path: identity, then
+// the whole file read from that same handle and indexed in one pass, so the
+// identity always describes the bytes indexed. Spans point into
+// s->index.backing. Returns 0, or -1 if f can't be read or memory runs out.
+int    sgml_index_build(sgml_sidecar *s, const sgml_file *f, const char *path,
+                        sgml_parse_stats *stats);
+
+// Index of the submission at path, from its sidecar when the file is
+// unchanged, else built with one parse and stored for next time (failing to
+// store it is not an error). Sidecars go to cache_dir, named by a hash of
+// path, or next to the file as <path>.sgmlidx when cache_dir is NULL.
+// Leaves the submission open in f for sgml_index_read_document; close it
+// with sgml_file_close. *hit says whether the sidecar was used. Returns 0,
+// or -1 if the submission can't be read.
+int    sgml_index_cache_get(const char *cache_dir, const char *path, sgml_sidecar *s,
+                            sgml_file *f, int *hit);
+
+// First document whose TYPE or FILENAME is name, or NULL
+const sgml_index_entry *sgml_index_find(const sgml_doc_index *ix, const char *name, size_t name_len);
+
+// Bytes sgml_index_read_document produces for e: the decoded size of a
+// uuencoded document, the content length otherwise
+size_t sgml_index_document_size(const sgml_index_entry *e);
+
+// Reads e's content from f, the file the index was built from, into out.
+// Plain documents are one pread straight into out; uuencoded ones are read
+// into a temporary buffer and decoded into out. Returns 0, or -1 on a read
+// error, a short read (the file changed since it was indexed), running out
+// of memory, or out_cap below sgml_index_document_size.
+int    sgml_index_read_document(const sgml_file *f, const sgml_index_entry *e,
+                                uint8_t *out, size_t out_cap, size_t *out_len);
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef SGML_INSTRUMENT_H
+#define SGML_INSTRUMENT_H
+
+#include <stdint.h>
+
+// ---------------------------------------------------------------------------
+// Hot-path instrumentation -- compiled in with -DSECSGML_INSTRUMENT
+//
+// Without the define every macro expands to nothing, so the timer calls and
+// counter updates cost nothing in a normal build. Counters go to a
+// sgml_parse_stats; a NULL stats pointer skips them at run time too.
+// ---------------------------------------------------------------------------
+#ifdef SECSGML_INSTRUMENT
+
+#ifdef _WIN32
+#include <windows.h>
+static inline uint64_t sgml_now_ns(void) {
+    static LARGE_INTEGER freq = {0};
+    LARGE_INTEGER counter;
+    if (freq.QuadPart == 0) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)((double)counter.QuadPart * 1e9 / (double)freq.QuadPart);
+}
+#else
+#include <time.h>
+static inline uint64_t sgml_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+// INSTR_START(stats, t0) ... INSTR_ADD(stats, field, t0) adds the elapsed
+// time to stats->time.field
+#define INSTR_START(stats, t0)       uint64_t t0 = (stats) ? sgml_now_ns() : 0
+#define INSTR_ADD(stats, field, t0)  do { if (stats) (stats)->time.field += sgml_now_ns() - (t0); } while (0)
+#define INSTR(stmt)                  do { stmt; } while (0)
+
+#else
+
+#define INSTR_START(stats, t0)       ((void)0)
+#define INSTR_ADD(stats, field, t0)  ((void)0)
+#define INSTR(stmt)                  ((void)0)
+
+#endif
+
+#endif
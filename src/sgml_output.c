@@ -0,0 +1,640 @@
+#include "sgml_output.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "scan.h"
+#include "sgml_thread.h"
+
+#ifdef _WIN32
+#include <direct.h>
+int sgml_make_dir(const char *path) {
+    if (_mkdir(path) == 0) return 0;
+    if (errno == EEXIST) return 0;
+    return -1;
+}
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+int sgml_make_dir(const char *path) {
+    if (mkdir(path, 0755) == 0) return 0;
+    if (errno == EEXIST) return 0;
+    return -1;
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// Output buffer -- JSON and CSV are formatted in memory and written in one go
+// ---------------------------------------------------------------------------
+typedef struct {
+    char  *data;
+    size_t len;
+    size_t cap;
+    int    oom;   // a reserve failed; the contents are incomplete
+} out_buf;
+
+static int buf_reserve(out_buf *b, size_t extra) {
+    if (b->len + extra <= b->cap) return 1;
+    if (b->oom) return 0;
+    size_t cap = b->cap ? b->cap * 2 : 4096;
+    while (cap < b->len + extra) cap *= 2;
+    char *tmp = (char *)realloc(b->data, cap);
+    if (!tmp) {
+        b->oom = 1;
+        return 0;
+    }
+    b->data = tmp;
+    b->cap  = cap;
+    return 1;
+}
+
+// Unchecked: the caller reserved room
+static void buf_put(out_buf *b, const void *p, size_t len) {
+    if (len) memcpy(b->data + b->len, p, len);  // p is NULL for a missing field
+    b->len += len;
+}
+
+static void buf_putc(out_buf *b, char c) {
+    if (buf_reserve(b, 1)) b->data[b->len++] = c;
+}
+
+// Hands the buffer to the caller, or frees it and returns NULL after an OOM
+static char *buf_finish(out_buf *b, size_t *out_len) {
+    if (b->oom) {
+        free(b->data);
+        *out_len = 0;
+        return NULL;
+    }
+    *out_len = b->len;
+    return b->data ? b->data : (char *)calloc(1, 1);
+}
+
+// ---------------------------------------------------------------------------
+// JSON -- submission metadata as nested objects, repeated keys as arrays
+// ---------------------------------------------------------------------------
+static int key_eq(byte_span a, byte_span b) {
+    if (a.len != b.len) return 0;
+    if (a.len == 0) return 1;
+    return memcmp(a.ptr, b.ptr, a.len) == 0;
+}
+
+// Scratch shared by every level of one write. A level's members, groups and
+// hash slots sit on top of its ancestors' and are popped on return; members
+// of the open levels are distinct events, so count entries are enough.
+typedef struct {
+    byte_span key;
+    submission_event_type type;
+    size_t idx;
+    size_t end_idx;
+    size_t group;
+    size_t next_same;   // next member with the same key, or SIZE_MAX
+} json_member;
+
+typedef struct {
+    size_t first;
+    size_t last;
+    size_t count;
+    int    emitted;
+} json_group;
+
+typedef struct {
+    const submission_event *events;
+    size_t      *section_end;   // per SECTION_START: matching SECTION_END, or count
+    json_member *members;
+    json_group  *groups;        // same slots as members
+    size_t      *slots;         // hash slots, group index + 1, 0 = empty
+    size_t       top;           // members/groups in use
+    size_t       slot_top;
+    sgml_find_lt_fn find_escape;
+    int          utf8;          // pass valid UTF-8 through
+} json_ctx;
+
+// Length of the valid UTF-8 sequence at p (no overlongs, surrogates or code
+// points past U+10FFFF), or 0
+static size_t utf8_sequence(const uint8_t *p, const uint8_t *end) {
+    size_t avail = (size_t)(end - p);
+    uint8_t c = p[0];
+    if (c >= 0xC2 && c <= 0xDF) {
+        return avail >= 2 && (p[1] & 0xC0) == 0x80 ? 2 : 0;
+    }
+    if (c >= 0xE0 && c <= 0xEF) {
+        if (avail < 3 || (p[1] & 0xC0) != 0x80 || (p[2] & 0xC0) != 0x80) return 0;
+        if (c == 0xE0 && p[1] < 0xA0) return 0;
+        if (c == 0xED && p[1] > 0x9F) return 0;
+        return 3;
+    }
+    if (c >= 0xF0 && c <= 0xF4) {
+        if (avail < 4 || (p[1] & 0xC0) != 0x80 || (p[2] & 0xC0) != 0x80 || (p[3] & 0xC0) != 0x80) return 0;
+        if (c == 0xF0 && p[1] < 0x90) return 0;
+        if (c == 0xF4 && p[1] > 0x8F) return 0;
+        return 4;
+    }
+    return 0;
+}
+
+// Runs without '"', '\\', control or non-ASCII bytes are found with the SIMD
+// kernel and copied whole. Quote, backslash and the common controls get
+// their short escapes; other controls, and bytes >= 0x80 unless utf8 is set
+// and they form valid UTF-8, are \u00XX.
+static void write_json_string(out_buf *b, const json_ctx *c, byte_span s) {
+    static const char hex[] = "0123456789ABCDEF";
+    const uint8_t *p = s.ptr, *end = s.ptr + s.len;
+    buf_putc(b, '"');
+    while (p < end) {
+        const uint8_t *q = c->find_escape(p, end);
+        if (!q) q = end;
+        if (q > p) {
+            if (!buf_reserve(b, (size_t)(q - p))) return;
+            buf_put(b, p, (size_t)(q - p));
+            p = q;
+        }
+        if (p == end) break;
+
+        uint8_t ch = *p;
+        size_t n = ch >= 0x80 && c->utf8 ? utf8_sequence(p, end) : 0;
+        if (!buf_reserve(b, 6)) return;
+        if (n) {
+            buf_put(b, p, n);
+            p += n;
+            continue;
+        }
+        char esc = 0;
+        switch (ch) {
+        case '"':  esc = '"';  break;
+        case '\\': esc = '\\'; break;
+        case '\n': esc = 'n';  break;
+        case '\r': esc = 'r';  break;
+        case '\t': esc = 't';  break;
+        case '\b': esc = 'b';  break;
+        case '\f': esc = 'f';  break;
+        }
+        if (esc) {
+            b->data[b->len++] = '\\';
+            b->data[b->len++] = esc;
+        } else {
+            buf_put(b, "\\u00", 4);
+            b->data[b->len++] = hex[ch >> 4];
+            b->data[b->len++] = hex[ch & 15];
+        }
+        p++;
+    }
+    buf_putc(b, '"');
+}
+
+static uint32_t key_hash(byte_span k) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < k.len; i++) h = (h ^ k.ptr[i]) * 16777619u;
+    return h;
+}
+
+// One backward pass: a SECTION_START's end is the first SECTION_END after it
+// at the same depth
+static int compute_section_ends(json_ctx *c, size_t count, int *max_depth) {
+    int maxd = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (c->events[i].depth > maxd) maxd = c->events[i].depth;
+    }
+    size_t *next_end = (size_t *)malloc(((size_t)maxd + 1) * sizeof(size_t));
+    if (!next_end) return 0;
+    for (int d = 0; d <= maxd; d++) next_end[d] = count;
+    for (size_t i = count; i-- > 0;) {
+        const submission_event *e = &c->events[i];
+        if (e->depth < 0) {
+            c->section_end[i] = count;
+        } else if (e->type == SUB_EVENT_SECTION_END) {
+            next_end[e->depth] = i;
+        } else if (e->type == SUB_EVENT_SECTION_START) {
+            c->section_end[i] = next_end[e->depth];
+        }
+    }
+    free(next_end);
+    *max_depth = maxd;
+    return 1;
+}
+
+static void write_object_range(out_buf *b, json_ctx *c, size_t start_idx, size_t end_idx, int depth) {
+    const submission_event *events = c->events;
+    size_t base = c->top, slot_base = c->slot_top;
+    json_member *members = c->members + base;
+    json_group  *groups  = c->groups + base;
+    size_t member_count = 0;
+
+    for (size_t i = start_idx; i < end_idx; i++) {
+        if (events[i].depth != depth + 1) continue;
+        if (events[i].type == SUB_EVENT_KEYVAL) {
+            members[member_count++] = (json_member){ events[i].key, events[i].type, i, i, 0, SIZE_MAX };
+        } else if (events[i].type == SUB_EVENT_SECTION_START) {
+            size_t end = c->section_end[i] < end_idx ? c->section_end[i] : end_idx;
+            members[member_count++] = (json_member){ events[i].key, events[i].type, i, end, 0, SIZE_MAX };
+            i = end;
+        }
+    }
+    c->top = base + member_count;
+
+    // Group repeated keys; each group chains its members in order
+    size_t nslots = 8;
+    while (nslots < member_count * 2) nslots <<= 1;
+    size_t *slots = c->slots + slot_base;
+    memset(slots, 0, nslots * sizeof(size_t));
+    c->slot_top = slot_base + nslots;
+    size_t group_count = 0;
+    for (size_t m = 0; m < member_count; m++) {
+        size_t h = key_hash(members[m].key) & (nslots - 1);
+        while (slots[h] && !key_eq(members[groups[slots[h] - 1].first].key, members[m].key)) {
+            h = (h + 1) & (nslots - 1);
+        }
+        if (slots[h]) {
+            json_group *g = &groups[slots[h] - 1];
+            members[g->last].next_same = m;
+            g->last = m;
+            g->count++;
+            members[m].group = slots[h] - 1;
+        } else {
+            groups[group_count] = (json_group){ m, m, 1, 0 };
+            members[m].group = group_count++;
+            slots[h] = group_count;
+        }
+    }
+
+    buf_putc(b, '{');
+    int first = 1;
+    for (size_t i = 0; i < member_count; i++) {
+        json_group *g = &groups[members[i].group];
+        if (g->count > 1 && g->emitted) continue;
+
+        if (!first) buf_putc(b, ',');
+        first = 0;
+        write_json_string(b, c, members[i].key);
+        buf_putc(b, ':');
+
+        size_t j = i;
+        if (g->count > 1) buf_putc(b, '[');
+        for (;;) {
+            if (members[j].type == SUB_EVENT_KEYVAL) {
+                write_json_string(b, c, events[members[j].idx].value);
+            } else {
+                write_object_range(b, c, members[j].idx + 1, members[j].end_idx, depth + 1);
+            }
+            if (g->count == 1 || members[j].next_same == SIZE_MAX) break;
+            j = members[j].next_same;
+            buf_putc(b, ',');
+        }
+        if (g->count > 1) {
+            buf_putc(b, ']');
+            g->emitted = 1;
+        }
+    }
+    buf_putc(b, '}');
+
+    c->top = base;
+    c->slot_top = slot_base;
+}
+
+char *sgml_format_submission_json_ex(const standardized_submission_metadata *m,
+                                     const sgml_output_options *opts, size_t *out_len) {
+    out_buf b = {0};
+    size_t n = m->count;
+    json_ctx c = {0};
+    int max_depth = 0;
+    c.events      = m->events;
+    c.find_escape = sgml_select_find_json_escape();
+    c.utf8        = opts ? opts->utf8 : 0;
+    c.section_end = (size_t *)malloc((n + 1) * sizeof(size_t));
+    c.members     = (json_member *)malloc((n + 1) * sizeof(json_member));
+    c.groups      = (json_group *)malloc((n + 1) * sizeof(json_group));
+    if (c.section_end && c.members && c.groups && compute_section_ends(&c, n, &max_depth)) {
+        // At most 4 slots per member plus the 8-slot minimum per open level
+        c.slots = (size_t *)malloc((4 * n + 8 * ((size_t)max_depth + 3)) * sizeof(size_t));
+    }
+    if (c.slots) {
+        write_object_range(&b, &c, 0, n, -1);
+        buf_putc(&b, '\n');
+    } else {
+        b.oom = 1;
+    }
+    free(c.slots);
+    free(c.groups);
+    free(c.members);
+    free(c.section_end);
+    return buf_finish(&b, out_len);
+}
+
+char *sgml_format_submission_json(const standardized_submission_metadata *m, size_t *out_len) {
+    return sgml_format_submission_json_ex(m, NULL, out_len);
+}
+
+void sgml_write_submission_json(FILE *f, const standardized_submission_metadata *m) {
+    size_t len;
+    char *json = sgml_format_submission_json(m, &len);
+    if (json) fwrite(json, 1, len, f);
+    free(json);
+}
+
+// ---------------------------------------------------------------------------
+// CSV
+// ---------------------------------------------------------------------------
+static int csv_needs_quotes(byte_span s) {
+    for (size_t i = 0; i < s.len; i++) {
+        unsigned char c = s.ptr[i];
+        if (c == '"' || c == ',' || c == '\n' || c == '\r') return 1;
+    }
+    return 0;
+}
+
+// Quoted cells copy the runs between '"' in bulk and double each quote
+static int csv_cell(out_buf *b, byte_span s) {
+    if (!s.ptr) s.len = 0;
+    if (!csv_needs_quotes(s)) {
+        if (!buf_reserve(b, s.len + 1)) return 0;
+        buf_put(b, s.ptr, s.len);
+        return 1;
+    }
+    if (!buf_reserve(b, s.len * 2 + 3)) return 0;
+    b->data[b->len++] = '"';
+    const uint8_t *p = s.ptr, *end = s.ptr + s.len;
+    while (p < end) {
+        const uint8_t *q = (const uint8_t *)memchr(p, '"', (size_t)(end - p));
+        if (!q) {
+            buf_put(b, p, (size_t)(end - p));
+            break;
+        }
+        buf_put(b, p, (size_t)(q - p) + 1);
+        b->data[b->len++] = '"';
+        p = q + 1;
+    }
+    b->data[b->len++] = '"';
+    return 1;
+}
+
+static int format_document_csv(out_buf *b, const sgml_parse_result *r) {
+    static const char header[] = "TYPE,SEQUENCE,FILENAME,DESCRIPTION\n";
+    if (!buf_reserve(b, sizeof(header) - 1)) return 0;
+    buf_put(b, header, sizeof(header) - 1);
+    for (size_t i = 0; i < r->doc_count; i++) {
+        const document *doc = &r->docs[i];
+        if (!csv_cell(b, doc->meta.type)) return 0;
+        b->data[b->len++] = ',';
+        if (!csv_cell(b, doc->meta.sequence)) return 0;
+        b->data[b->len++] = ',';
+        if (!csv_cell(b, doc->meta.filename)) return 0;
+        b->data[b->len++] = ',';
+        if (!csv_cell(b, doc->meta.description)) return 0;
+        b->data[b->len++] = '\n';
+    }
+    return 1;
+}
+
+char *sgml_format_document_csv(const sgml_parse_result *r, size_t *out_len) {
+    out_buf b = {0};
+    format_document_csv(&b, r);
+    return buf_finish(&b, out_len);
+}
+
+void sgml_write_document_csv(FILE *f, const sgml_parse_result *r) {
+    size_t len;
+    char *csv = sgml_format_document_csv(r, &len);
+    if (csv) fwrite(csv, 1, len, f);
+    free(csv);
+}
+
+void sgml_sanitize_filename(char *dst, size_t dst_cap, byte_span name, size_t index) {
+    if (!dst || dst_cap == 0) return;
+    size_t pos = 0;
+    if (name.ptr && name.len > 0) {
+        for (size_t i = 0; i < name.len && pos + 1 < dst_cap; i++) {
+            unsigned char c = name.ptr[i];
+            if (c == '\\' || c == '/' || c == ':' || c == '*' || c == '?' ||
+                c == '"'  || c == '<' || c == '>' || c == '|') {
+                c = '_';
+            }
+            dst[pos++] = (char)c;
+        }
+        dst[pos] = '\0';
+        if (pos > 0) return;
+    }
+    snprintf(dst, dst_cap, "doc_%zu.bin", index);
+}
+
+byte_span sgml_document_payload(const document *doc) {
+    byte_span out = { NULL, 0 };
+    if (doc->is_uuencoded && doc->decoded && doc->decoded_len > 0) {
+        out.ptr = doc->decoded;
+        out.len = doc->decoded_len;
+    } else if (!doc->is_uuencoded && doc->content_start && doc->content_len > 0) {
+        out.ptr = doc->content_start;
+        out.len = doc->content_len;
+    }
+    return out;
+}
+
+// ---------------------------------------------------------------------------
+// File writes -- relative to one directory fd on POSIX, so each file costs
+// one openat and pwrites instead of a path walk and stdio buffering
+// ---------------------------------------------------------------------------
+#define FILENAME_CAP 512
+
+typedef struct {
+    const char  *out_dir;
+    int          dir_fd;     // -1 on Windows
+} out_target;
+
+static int target_open(out_target *t, const char *out_dir) {
+    t->out_dir = out_dir;
+    t->dir_fd  = -1;
+#ifndef _WIN32
+    t->dir_fd = open(out_dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (t->dir_fd < 0) return 0;
+#endif
+    return 1;
+}
+
+static void target_close(out_target *t) {
+#ifndef _WIN32
+    if (t->dir_fd >= 0) close(t->dir_fd);
+#endif
+    t->dir_fd = -1;
+}
+
+// Creates or truncates name in the target and writes len bytes. 0 on failure.
+static int write_file(const out_target *t, const char *name, const void *data, size_t len) {
+#ifdef _WIN32
+    char path[1200];
+    snprintf(path, sizeof(path), "%s" PATH_SEP "%s", t->out_dir, name);
+    FILE *f = fopen(path, "wb");
+    if (!f) return 0;
+    int ok = len == 0 || fwrite(data, 1, len, f) == len;
+    if (fclose(f) != 0) ok = 0;
+    return ok;
+#else
+    int fd = openat(t->dir_fd, name, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return 0;
+    const uint8_t *p = (const uint8_t *)data;
+    size_t off = 0;
+    int ok = 1;
+    while (off < len) {
+        size_t n = len - off > (1u << 30) ? (1u << 30) : len - off;
+        ssize_t w = pwrite(fd, p + off, n, (off_t)off);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            ok = 0;
+            break;
+        }
+        off += (size_t)w;
+    }
+    if (close(fd) != 0) ok = 0;
+    return ok;
+#endif
+}
+
+static void report_write_failure(const out_target *t, const char *name) {
+    fprintf(stderr, "Failed to write document: %s" PATH_SEP "%s\n", t->out_dir, name);
+}
+
+// ---------------------------------------------------------------------------
+// Document files -- claimed one at a time by a small pool of threads
+// ---------------------------------------------------------------------------
+typedef struct {
+    const out_target *target;
+    const sgml_parse_result *r;
+    const char *names;       // doc_count names of FILENAME_CAP bytes
+    const uint8_t *skip;     // 1 = a later document has the same name
+    size_t next;
+    sgml_mutex lock;
+} doc_pool;
+
+static void write_document(doc_pool *pool, size_t i) {
+    if (pool->skip[i]) return;
+    const document *doc = &pool->r->docs[i];
+    const char *name = pool->names + i * FILENAME_CAP;
+
+    byte_span payload = sgml_document_payload(doc);
+    if (!write_file(pool->target, name, payload.ptr, payload.len)) report_write_failure(pool->target, name);
+}
+
+static SGML_THREAD_FUNC(doc_pool_main, arg) {
+    doc_pool *pool = (doc_pool *)arg;
+    for (;;) {
+        sgml_mutex_lock(&pool->lock);
+        size_t i = pool->next++;
+        sgml_mutex_unlock(&pool->lock);
+        if (i >= pool->r->doc_count) break;
+        write_document(pool, i);
+    }
+    return SGML_THREAD_RETURN;
+}
+
+static int cmp_name(const void *a, const void *b) {
+    return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+// Documents that share a sanitized name: only the last one is written, which
+// is what writing them in order leaves on disk, and it keeps the parallel
+// writes from racing on one file
+static void mark_duplicate_names(const char *names, size_t count, uint8_t *skip) {
+    const char **sorted = (const char **)malloc(count * sizeof(char *));
+    if (!sorted) return;
+    for (size_t i = 0; i < count; i++) sorted[i] = names + i * FILENAME_CAP;
+    qsort(sorted, count, sizeof(char *), cmp_name);
+    for (size_t i = 0; i + 1 < count; i++) {
+        if (strcmp(sorted[i], sorted[i + 1]) != 0) continue;
+        // Group of equal names: keep the highest index
+        size_t j = i;
+        const char *keep = sorted[i];
+        while (j + 1 < count && strcmp(sorted[j + 1], sorted[i]) == 0) {
+            j++;
+            if (sorted[j] > keep) keep = sorted[j];
+        }
+        for (size_t k = i; k <= j; k++) {
+            if (sorted[k] != keep) skip[(size_t)(sorted[k] - names) / FILENAME_CAP] = 1;
+        }
+        i = j;
+    }
+    free(sorted);
+}
+
+static void write_documents(const out_target *t, const sgml_parse_result *r, int threads) {
+    if (r->doc_count == 0) return;
+    char *names = (char *)malloc(r->doc_count * FILENAME_CAP);
+    uint8_t *skip = (uint8_t *)calloc(r->doc_count, 1);
+    if (!names || !skip) {
+        free(names);
+        free(skip);
+        fprintf(stderr, "Out of memory writing documents to %s\n", t->out_dir);
+        return;
+    }
+    for (size_t i = 0; i < r->doc_count; i++) {
+        sgml_sanitize_filename(names + i * FILENAME_CAP, FILENAME_CAP, r->docs[i].meta.filename, i + 1);
+    }
+    mark_duplicate_names(names, r->doc_count, skip);
+
+    doc_pool pool;
+    memset(&pool, 0, sizeof(pool));
+    pool.target = t;
+    pool.r      = r;
+    pool.names  = names;
+    pool.skip   = skip;
+    if (threads <= 0) threads = sgml_cpu_count();
+    if (r->doc_count < SGML_WRITE_PARALLEL_MIN) threads = 1;
+    if ((size_t)threads > r->doc_count) threads = (int)r->doc_count;
+
+    if (threads <= 1) {
+        for (size_t i = 0; i < r->doc_count; i++) write_document(&pool, i);
+    } else {
+        sgml_mutex_init(&pool.lock);
+        sgml_thread *tids = (sgml_thread *)malloc((size_t)threads * sizeof(sgml_thread));
+        int started = 0;
+        for (int i = 1; tids && i < threads; i++) {
+            if (!sgml_thread_start(&tids[i], doc_pool_main, &pool)) break;
+            started = i;
+        }
+        doc_pool_main(&pool);  // calling thread writes too
+        for (int i = 1; i <= started; i++) sgml_thread_join(tids[i]);
+        free(tids);
+        sgml_mutex_destroy(&pool.lock);
+    }
+    free(names);
+    free(skip);
+}
+
+int sgml_write_outputs_ex(const char *out_dir, const sgml_parse_result *r,
+                          const standardized_submission_metadata *m, const sgml_output_options *opts) {
+    if (sgml_make_dir(out_dir) != 0) {
+        fprintf(stderr, "Failed to create output dir: %s\n", out_dir);
+        return -1;
+    }
+    out_target t;
+    if (!target_open(&t, out_dir)) {
+        fprintf(stderr, "Failed to open output dir: %s\n", out_dir);
+        return -1;
+    }
+
+    if (m && m->count > 0) {
+        size_t json_len;
+        char *json = sgml_format_submission_json_ex(m, opts, &json_len);
+        if (!json || !write_file(&t, "submission_metadata.json", json, json_len)) {
+            fprintf(stderr, "Failed to open submission metadata file: %s" PATH_SEP "submission_metadata.json\n",
+                    out_dir);
+        }
+        free(json);
+    }
+
+    size_t csv_len;
+    char *csv = sgml_format_document_csv(r, &csv_len);
+    if (!csv || !write_file(&t, "document_metadata.csv", csv, csv_len)) {
+        fprintf(stderr, "Failed to open metadata file: %s" PATH_SEP "document_metadata.csv\n", out_dir);
+        free(csv);
+        target_close(&t);
+        return -1;
+    }
+    free(csv);
+
+    write_documents(&t, r, opts ? opts->threads : 1);
+    target_close(&t);
+    return 0;
+}
+
+int sgml_write_outputs(const char *out_dir, const sgml_parse_result *r, const standardized_submission_metadata *m) {
+    return sgml_write_outputs_ex(out_dir, r, m, NULL);
+}
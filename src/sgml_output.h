@@ -0,0 +1,64 @@
+#ifndef SGML_OUTPUT_H
+#define SGML_OUTPUT_H
+
+#include <stdio.h>
+
+#include "secsgml.h"
+#include "standardize_submission_metadata.h"
+
+// ---------------------------------------------------------------------------
+// Output writers -- what parsesgml writes for one submission:
+//   <out_dir>/submission_metadata.json   standardized header
+//   <out_dir>/document_metadata.csv      TYPE,SEQUENCE,FILENAME,DESCRIPTION
+//   <out_dir>/<FILENAME>                 one file per document
+// ---------------------------------------------------------------------------
+#ifdef _WIN32
+#define PATH_SEP "\\"
+#else
+#define PATH_SEP "/"
+#endif
+
+int  sgml_make_dir(const char *path);  // 0 if created or already there
+
+void sgml_write_submission_json(FILE *f, const standardized_submission_metadata *m);
+void sgml_write_document_csv(FILE *f, const sgml_parse_result *r);
+
+// What gets written for a document: the decoded bytes if uuencoded,
+// otherwise the content span. Empty when there is nothing to write.
+byte_span sgml_document_payload(const document *doc);
+
+// Document FILENAME with path characters replaced, or doc_<index>.bin
+void sgml_sanitize_filename(char *dst, size_t dst_cap, byte_span name, size_t index);
+
+// Submissions with fewer documents than this write on the calling thread
+#define SGML_WRITE_PARALLEL_MIN 4
+
+typedef struct {
+    // Threads writing document files. 0 = one per core, 1 = calling thread.
+    // Batch workers already fill the cores and use 1.
+    int threads;
+    // JSON strings escape '"', '\\' and control bytes; bytes >= 0x80 are
+    // \u00XX unless this is set, in which case valid UTF-8 is written as-is
+    // (invalid bytes are still escaped).
+    int utf8;
+} sgml_output_options;
+
+// What sgml_write_submission_json/_document_csv write, in a malloc'd buffer
+// (*out_len bytes, free() it), or NULL when out of memory. The JSON _ex
+// variant takes opts->utf8; NULL = defaults.
+char *sgml_format_submission_json(const standardized_submission_metadata *m, size_t *out_len);
+char *sgml_format_submission_json_ex(const standardized_submission_metadata *m,
+                                     const sgml_output_options *opts, size_t *out_len);
+char *sgml_format_document_csv(const sgml_parse_result *r, size_t *out_len);
+
+// All of the above into out_dir. Returns 0, or -1 if the directory or the CSV
+// can't be created. Files are created relative to one directory handle and
+// written with pwrite; document files are spread over opts->threads threads.
+// Documents whose sanitized names collide leave the last one on disk, as a
+// sequential write would. opts NULL = calling thread only.
+int  sgml_write_outputs(const char *out_dir, const sgml_parse_result *r,
+                        const standardized_submission_metadata *m);
+int  sgml_write_outputs_ex(const char *out_dir, const sgml_parse_result *r,
+                           const standardized_submission_metadata *m, const sgml_output_options *opts);
+
+#endif
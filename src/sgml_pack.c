@@ -0,0 +1,329 @@
+#include "sgml_pack.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "sgml_output.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#define PACK_NAME_CAP 512
+
+static const char JSON_NAME[] = "submission_metadata.json";
+static const char CSV_NAME[]  = "document_metadata.csv";
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static void put_u64(uint8_t *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+static uint64_t get_u64(const uint8_t *p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+// ---------------------------------------------------------------------------
+// Gathered write -- one writev per IOV_MAX pieces, resumed after short writes
+// ---------------------------------------------------------------------------
+typedef struct {
+    const void *ptr;
+    size_t      len;
+} pack_piece;
+
+#ifdef _WIN32
+static int write_pieces(const char *path, const pack_piece *pieces, size_t count) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return 0;
+    int ok = 1;
+    for (size_t i = 0; i < count && ok; i++) {
+        if (pieces[i].len && fwrite(pieces[i].ptr, 1, pieces[i].len, f) != pieces[i].len) ok = 0;
+    }
+    if (fclose(f) != 0) ok = 0;
+    return ok;
+}
+#else
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+static int write_pieces(const char *path, const pack_piece *pieces, size_t count) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return 0;
+
+    struct iovec iov[IOV_MAX < 1024 ? IOV_MAX : 1024];
+    size_t iov_cap = sizeof(iov) / sizeof(iov[0]);
+    size_t next = 0;   // first piece not fully written
+    size_t skip = 0;   // bytes of pieces[next] already written
+    int ok = 1;
+    while (ok) {
+        while (next < count && pieces[next].len == skip) {
+            next++;
+            skip = 0;
+        }
+        if (next == count) break;
+
+        size_t n = 0;
+        for (size_t i = next; i < count && n < iov_cap; i++) {
+            iov[n].iov_base = (void *)pieces[i].ptr;
+            iov[n].iov_len  = pieces[i].len;
+            n++;
+        }
+        iov[0].iov_base = (uint8_t *)iov[0].iov_base + skip;
+        iov[0].iov_len -= skip;
+
+        ssize_t w = writev(fd, iov, (int)n);
+        if (w < 0) {
+            if (errno != EINTR) ok = 0;
+            continue;
+        }
+        size_t done = (size_t)w;
+        while (done > 0) {
+            size_t rest = pieces[next].len - skip;
+            if (done < rest) {
+                skip += done;
+                break;
+            }
+            done -= rest;
+            next++;
+            skip = 0;
+        }
+    }
+    if (close(fd) != 0) ok = 0;
+    return ok;
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// Writer
+// ---------------------------------------------------------------------------
+int sgml_write_pack_ex(const char *path, const sgml_parse_result *r,
+                       const standardized_submission_metadata *m, const sgml_output_options *opts) {
+    size_t json_len = 0, csv_len = 0;
+    char *json = NULL;
+    if (m && m->count > 0) {
+        json = sgml_format_submission_json_ex(m, opts, &json_len);
+        if (!json) return -1;
+    }
+    char *csv = sgml_format_document_csv(r, &csv_len);
+    if (!csv) {
+        free(json);
+        return -1;
+    }
+
+    size_t count = (json ? 1 : 0) + 1 + r->doc_count;
+    char *names = (char *)malloc(r->doc_count * PACK_NAME_CAP + 1);
+    size_t *name_lens = (size_t *)malloc((r->doc_count + 1) * sizeof(size_t));
+    pack_piece *pieces = (pack_piece *)malloc((r->doc_count + 1) * sizeof(pack_piece));
+    uint8_t *meta = NULL;
+    int ok = names && name_lens && pieces;
+
+    size_t names_len = 0;
+    if (ok) {
+        names_len = (json ? sizeof(JSON_NAME) - 1 : 0) + sizeof(CSV_NAME) - 1;
+        for (size_t i = 0; i < r->doc_count; i++) {
+            char *dst = names + i * PACK_NAME_CAP;
+            sgml_sanitize_filename(dst, PACK_NAME_CAP, r->docs[i].meta.filename, i + 1);
+            name_lens[i] = strlen(dst);
+            names_len += name_lens[i];
+        }
+        size_t meta_len = SGML_PACK_HEADER_SIZE + count * SGML_PACK_ENTRY_SIZE + names_len + json_len + csv_len;
+        meta = (uint8_t *)malloc(meta_len);
+        ok = meta != NULL;
+
+        if (ok) {
+            uint8_t *hdr = meta;
+            uint8_t *ent = meta + SGML_PACK_HEADER_SIZE;
+            uint8_t *nam = ent + count * SGML_PACK_ENTRY_SIZE;
+            uint64_t names_off = (uint64_t)(nam - meta);
+            uint64_t data_off  = names_off + names_len;
+            size_t name_pos = 0;
+
+            memcpy(hdr, SGML_PACK_MAGIC, 8);
+            put_u32(hdr + 8, SGML_PACK_VERSION);
+            put_u32(hdr + 12, (uint32_t)count);
+            put_u64(hdr + 16, names_off);
+            put_u64(hdr + 24, names_len);
+
+#define PUT_ENTRY(name_ptr, name_n, len, flags)                          \
+            do {                                                         \
+                put_u64(ent, data_off);                                  \
+                put_u64(ent + 8, (uint64_t)(len));                       \
+                put_u32(ent + 16, (uint32_t)name_pos);                   \
+                put_u32(ent + 20, (uint32_t)(name_n));                   \
+                put_u32(ent + 24, (flags));                              \
+                put_u32(ent + 28, 0);                                    \
+                memcpy(nam + name_pos, (name_ptr), (name_n));            \
+                name_pos += (name_n);                                    \
+                data_off += (uint64_t)(len);                             \
+                ent += SGML_PACK_ENTRY_SIZE;                             \
+            } while (0)
+
+            if (json) PUT_ENTRY(JSON_NAME, sizeof(JSON_NAME) - 1, json_len, 0u);
+            PUT_ENTRY(CSV_NAME, sizeof(CSV_NAME) - 1, csv_len, 0u);
+            for (size_t i = 0; i < r->doc_count; i++) {
+                const document *doc = &r->docs[i];
+                byte_span payload = sgml_document_payload(doc);
+                uint32_t flags = SGML_PACK_DOCUMENT | (doc->is_uuencoded ? SGML_PACK_UUDECODED : 0u);
+                PUT_ENTRY(names + i * PACK_NAME_CAP, name_lens[i], payload.len, flags);
+                pieces[i + 1].ptr = payload.ptr;
+                pieces[i + 1].len = payload.len;
+            }
+#undef PUT_ENTRY
+
+            // JSON and CSV follow the names, so they go out with the header
+            uint8_t *tail = nam + names_len;
+            if (json) memcpy(tail, json, json_len);
+            memcpy(tail + json_len, csv, csv_len);
+            pieces[0].ptr = meta;
+            pieces[0].len = meta_len;
+            ok = write_pieces(path, pieces, r->doc_count + 1);
+        }
+    }
+
+    free(meta);
+    free(pieces);
+    free(name_lens);
+    free(names);
+    free(csv);
+    free(json);
+    return ok ? 0 : -1;
+}
+
+int sgml_write_pack(const char *path, const sgml_parse_result *r,
+                    const standardized_submission_metadata *m) {
+    return sgml_write_pack_ex(path, r, m, NULL);
+}
+
+// ---------------------------------------------------------------------------
+// Reader
+// ---------------------------------------------------------------------------
+int sgml_pack_open_buffer(sgml_pack *p, const uint8_t *buf, size_t len) {
+    memset(p, 0, sizeof(*p));
+    if (!buf || len < SGML_PACK_HEADER_SIZE) return -1;
+    if (memcmp(buf, SGML_PACK_MAGIC, 8) != 0) return -1;
+    if (get_u32(buf + 8) != SGML_PACK_VERSION) return -1;
+
+    uint64_t count     = get_u32(buf + 12);
+    uint64_t names_off = get_u64(buf + 16);
+    uint64_t names_len = get_u64(buf + 24);
+    if (count > (len - SGML_PACK_HEADER_SIZE) / SGML_PACK_ENTRY_SIZE) return -1;
+    if (names_off < SGML_PACK_HEADER_SIZE + count * SGML_PACK_ENTRY_SIZE) return -1;
+    if (names_off > len || names_len > len - names_off) return -1;
+
+    for (uint64_t i = 0; i < count; i++) {
+        const uint8_t *e = buf + SGML_PACK_HEADER_SIZE + i * SGML_PACK_ENTRY_SIZE;
+        uint64_t off = get_u64(e), n = get_u64(e + 8);
+        uint64_t noff = get_u32(e + 16), nlen = get_u32(e + 20);
+        if (off > len || n > len - off) return -1;
+        if (noff > names_len || nlen > names_len - noff) return -1;
+    }
+    p->data  = buf;
+    p->len   = len;
+    p->count = (size_t)count;
+    return 0;
+}
+
+int sgml_pack_get(const sgml_pack *p, size_t index, sgml_pack_entry *out) {
+    if (index >= p->count) return 0;
+    const uint8_t *e = p->data + SGML_PACK_HEADER_SIZE + index * SGML_PACK_ENTRY_SIZE;
+    const uint8_t *names = p->data + get_u64(p->data + 16);
+    out->content.ptr = p->data + get_u64(e);
+    out->content.len = (size_t)get_u64(e + 8);
+    out->name.ptr    = names + get_u32(e + 16);
+    out->name.len    = get_u32(e + 20);
+    out->flags       = get_u32(e + 24);
+    return 1;
+}
+
+int sgml_pack_find(const sgml_pack *p, const char *name, size_t name_len, sgml_pack_entry *out) {
+    for (size_t i = p->count; i-- > 0;) {
+        sgml_pack_entry e;
+        if (!sgml_pack_get(p, i, &e)) continue;
+        if (e.name.len == name_len && memcmp(e.name.ptr, name, name_len) == 0) {
+            *out = e;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+#ifdef _WIN32
+int sgml_pack_open(sgml_pack *p, const char *path) {
+    memset(p, 0, sizeof(*p));
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return -1;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return -1;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    void *data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (!data || sgml_pack_open_buffer(p, (const uint8_t *)data, (size_t)size.QuadPart) != 0) {
+        if (data) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        return -1;
+    }
+    p->mapped  = 1;
+    p->file    = file;
+    p->mapping = mapping;
+    return 0;
+}
+
+void sgml_pack_close(sgml_pack *p) {
+    if (p->mapped) {
+        UnmapViewOfFile(p->data);
+        CloseHandle((HANDLE)p->mapping);
+        CloseHandle((HANDLE)p->file);
+    }
+    memset(p, 0, sizeof(*p));
+}
+#else
+int sgml_pack_open(sgml_pack *p, const char *path) {
+    memset(p, 0, sizeof(*p));
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return -1;
+    }
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return -1;
+    if (sgml_pack_open_buffer(p, (const uint8_t *)data, (size_t)st.st_size) != 0) {
+        munmap(data, (size_t)st.st_size);
+        return -1;
+    }
+    p->mapped = 1;
+    return 0;
+}
+
+void sgml_pack_close(sgml_pack *p) {
+    if (p->mapped) munmap((void *)p->data, p->len);
+    memset(p, 0, sizeof(*p));
+}
+#endif
@@ -0,0 +1,76 @@
+#ifndef SGML_PACK_H
+#define SGML_PACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "secsgml.h"
+#include "standardize_submission_metadata.h"
+#include "sgml_output.h"
+
+// ---------------------------------------------------------------------------
+// Pack -- one file per submission instead of a directory of N files
+//
+// Holds what sgml_write_outputs would put in the directory, under the same
+// names: submission_metadata.json (if any), document_metadata.csv, then one
+// entry per document. All integers are little-endian.
+//
+//   header   magic "SGMLPAK1", u32 version, u32 entry count,
+//            u64 name table offset, u64 name table length
+//   entries  entry count x { u64 offset, u64 length, u32 name offset,
+//                            u32 name length, u32 flags, u32 reserved }
+//   names    concatenated entry names, not terminated
+//   payloads concatenated entry contents, offsets are from the file start
+//
+// The writer builds header, entries, names, JSON and CSV in memory and hands
+// them to the OS together with the document payloads in one gathered write
+// (writev on POSIX), so document bytes are never copied.
+// ---------------------------------------------------------------------------
+#define SGML_PACK_MAGIC       "SGMLPAK1"
+#define SGML_PACK_VERSION     1
+#define SGML_PACK_HEADER_SIZE 32
+#define SGML_PACK_ENTRY_SIZE  32
+
+// Entry flags
+#define SGML_PACK_DOCUMENT    1u   // a document, not the JSON/CSV metadata
+#define SGML_PACK_UUDECODED   2u   // document was uuencoded; payload is decoded
+
+// Writes the pack to path. Returns 0, or -1 if it can't be created or written.
+// _ex formats the JSON entry with opts (see sgml_output_options); threads is
+// unused, the pack is one write.
+int  sgml_write_pack(const char *path, const sgml_parse_result *r,
+                     const standardized_submission_metadata *m);
+int  sgml_write_pack_ex(const char *path, const sgml_parse_result *r,
+                        const standardized_submission_metadata *m, const sgml_output_options *opts);
+
+typedef struct {
+    byte_span name;
+    byte_span content;
+    uint32_t  flags;
+} sgml_pack_entry;
+
+typedef struct {
+    const uint8_t *data;   // whole pack
+    size_t         len;
+    size_t         count;  // entries
+    int            mapped;
+#ifdef _WIN32
+    void          *file;
+    void          *mapping;
+#endif
+} sgml_pack;
+
+// Maps a pack read-only. Returns 0, or -1 if it can't be opened or is not a
+// valid pack (bad magic or version, entries out of bounds).
+int  sgml_pack_open(sgml_pack *p, const char *path);
+// Same checks over a pack already in memory; buf must outlive p.
+int  sgml_pack_open_buffer(sgml_pack *p, const uint8_t *buf, size_t len);
+void sgml_pack_close(sgml_pack *p);
+
+// Entry index, or 0 if index is out of range. Spans point into the pack.
+int  sgml_pack_get(const sgml_pack *p, size_t index, sgml_pack_entry *out);
+// Entry by name (sanitized document FILENAME, or one of the metadata names).
+// When documents share a name the last one wins, as on disk. 0 if not found.
+int  sgml_pack_find(const sgml_pack *p, const char *name, size_t name_len, sgml_pack_entry *out);
+
+#endif
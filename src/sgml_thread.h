@@ -0,0 +1,70 @@
+#ifndef SGML_THREAD_H
+#define SGML_THREAD_H
+
+// Minimal portable threads: start/join, a mutex, and a CPU count.
+// Win32 threads on Windows, pthreads elsewhere (link with -pthread).
+
+#ifdef _WIN32
+#include <windows.h>
+
+typedef HANDLE           sgml_thread;
+typedef CRITICAL_SECTION sgml_mutex;
+
+// Thread entry points are declared with SGML_THREAD_FUNC and end with
+// return SGML_THREAD_RETURN;
+#define SGML_THREAD_FUNC(name, arg) DWORD WINAPI name(LPVOID arg)
+#define SGML_THREAD_RETURN 0
+typedef LPTHREAD_START_ROUTINE sgml_thread_fn;
+
+static inline int sgml_thread_start(sgml_thread *t, sgml_thread_fn fn, void *arg) {
+    *t = CreateThread(NULL, 0, fn, arg, 0, NULL);
+    return *t != NULL;
+}
+
+static inline void sgml_thread_join(sgml_thread t) {
+    WaitForSingleObject(t, INFINITE);
+    CloseHandle(t);
+}
+
+static inline void sgml_mutex_init(sgml_mutex *m)    { InitializeCriticalSection(m); }
+static inline void sgml_mutex_destroy(sgml_mutex *m) { DeleteCriticalSection(m); }
+static inline void sgml_mutex_lock(sgml_mutex *m)    { EnterCriticalSection(m); }
+static inline void sgml_mutex_unlock(sgml_mutex *m)  { LeaveCriticalSection(m); }
+
+static inline int sgml_cpu_count(void) {
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwNumberOfProcessors > 0 ? (int)si.dwNumberOfProcessors : 1;
+}
+
+#else
+#include <pthread.h>
+#include <unistd.h>
+
+typedef pthread_t       sgml_thread;
+typedef pthread_mutex_t sgml_mutex;
+
+#define SGML_THREAD_FUNC(name, arg) void *name(void *arg)
+#define SGML_THREAD_RETURN NULL
+typedef void *(*sgml_thread_fn)(void *);
+
+static inline int sgml_thread_start(sgml_thread *t, sgml_thread_fn fn, void *arg) {
+    return pthread_create(t, NULL, fn, arg) == 0;
+}
+
+static inline void sgml_thread_join(sgml_thread t) {
+    pthread_join(t, NULL);
+}
+
+static inline void sgml_mutex_init(sgml_mutex *m)    { pthread_mutex_init(m, NULL); }
+static inline void sgml_mutex_destroy(sgml_mutex *m) { pthread_mutex_destroy(m); }
+static inline void sgml_mutex_lock(sgml_mutex *m)    { pthread_mutex_lock(m); }
+static inline void sgml_mutex_unlock(sgml_mutex *m)  { pthread_mutex_unlock(m); }
+
+static inline int sgml_cpu_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+#endif
+
+#endif
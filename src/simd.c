@@ -0,0 +1,64 @@
+#include "simd.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__) && (defined(__aarch64__) || defined(__arm__))
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+static const char *TIER_NAMES[] = { "scalar", "sse2", "ssse3", "avx2", "avx512vbmi", "neon" };
+
+const char *sgml_simd_name(sgml_simd_tier tier) {
+    if ((unsigned)tier >= sizeof(TIER_NAMES) / sizeof(TIER_NAMES[0])) return "unknown";
+    return TIER_NAMES[tier];
+}
+
+sgml_simd_tier sgml_simd_detect(void) {
+#if defined(SGML_X86_DISPATCH)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512vbmi") && __builtin_cpu_supports("avx512bw") &&
+        __builtin_cpu_supports("avx2")) return SGML_SIMD_AVX512VBMI;
+    if (__builtin_cpu_supports("avx2"))  return SGML_SIMD_AVX2;
+    if (__builtin_cpu_supports("ssse3")) return SGML_SIMD_SSSE3;
+    if (__builtin_cpu_supports("sse2"))  return SGML_SIMD_SSE2;
+    return SGML_SIMD_SCALAR;
+#elif defined(SGML_NEON_DISPATCH)
+#if defined(__linux__) && defined(__aarch64__) && defined(HWCAP_ASIMD)
+    return (getauxval(AT_HWCAP) & HWCAP_ASIMD) ? SGML_SIMD_NEON : SGML_SIMD_SCALAR;
+#elif defined(__linux__) && defined(__arm__) && defined(HWCAP_NEON)
+    return (getauxval(AT_HWCAP) & HWCAP_NEON) ? SGML_SIMD_NEON : SGML_SIMD_SCALAR;
+#else
+    return SGML_SIMD_NEON;  // built with NEON enabled, so the target has it
+#endif
+#else
+    return SGML_SIMD_SCALAR;
+#endif
+}
+
+// Forced tiers only ever lower the detected one; NEON and the x86 tiers
+// don't mix, so a request for the other family falls back to scalar.
+static sgml_simd_tier apply_override(sgml_simd_tier detected) {
+    const char *env = getenv("SECSGML_SIMD");
+    if (!env || !*env) return detected;
+    for (int t = SGML_SIMD_SCALAR; t <= SGML_SIMD_NEON; t++) {
+        if (strcmp(env, TIER_NAMES[t]) != 0) continue;
+        sgml_simd_tier want = (sgml_simd_tier)t;
+        if (want == SGML_SIMD_SCALAR) return want;
+        if ((want == SGML_SIMD_NEON) != (detected == SGML_SIMD_NEON)) return SGML_SIMD_SCALAR;
+        return want < detected ? want : detected;
+    }
+    return detected;
+}
+
+sgml_simd_tier sgml_simd_active(void) {
+    // -1 = not chosen yet. Racing first callers compute the same value.
+    static int cached = -1;
+    int t = __atomic_load_n(&cached, __ATOMIC_RELAXED);
+    if (t < 0) {
+        t = (int)apply_override(sgml_simd_detect());
+        __atomic_store_n(&cached, t, __ATOMIC_RELAXED);
+    }
+    return (sgml_simd_tier)t;
+}
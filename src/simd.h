@@ -0,0 +1,38 @@
+#ifndef SGML_SIMD_H
+#define SGML_SIMD_H
+
+// ---------------------------------------------------------------------------
+// Runtime SIMD tier selection
+//
+// Every kernel variant the target supports is compiled into the binary; the
+// best one for the running CPU is picked once on first use. Set
+// SECSGML_SIMD=scalar|sse2|ssse3|avx2|avx512vbmi|neon to force a lower tier
+// (a tier the CPU lacks falls back to the detected one).
+// ---------------------------------------------------------------------------
+typedef enum {
+    SGML_SIMD_SCALAR     = 0,
+    SGML_SIMD_SSE2       = 1,
+    SGML_SIMD_SSSE3      = 2,
+    SGML_SIMD_AVX2       = 3,
+    SGML_SIMD_AVX512VBMI = 4,
+    SGML_SIMD_NEON       = 5
+} sgml_simd_tier;
+
+// x86 variants are built with per-function target attributes, so the
+// translation unit itself needs no -m flags.
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SGML_X86_DISPATCH
+#define SGML_TARGET(t) __attribute__((target(t)))
+#define SGML_TARGET_SSE2       SGML_TARGET("sse2")
+#define SGML_TARGET_SSSE3      SGML_TARGET("ssse3")
+#define SGML_TARGET_AVX2       SGML_TARGET("avx2")
+#define SGML_TARGET_AVX512VBMI SGML_TARGET("avx2,avx512bw,avx512vbmi")
+#elif defined(__ARM_NEON)
+#define SGML_NEON_DISPATCH
+#endif
+
+sgml_simd_tier sgml_simd_detect(void);   // best tier this CPU supports
+sgml_simd_tier sgml_simd_active(void);   // detected, lowered by SECSGML_SIMD
+const char    *sgml_simd_name(sgml_simd_tier tier);
+
+#endif
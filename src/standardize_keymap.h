@@ -0,0 +1,96 @@
+// Generated by tools/gen_keymap.py -- edit the table there and rerun.
+// Included only by standardize_submission_metadata.c.
+#ifndef STANDARDIZE_KEYMAP_H
+#define STANDARDIZE_KEYMAP_H
+
+#define KEYMAP_SEED    0x000017ADu
+#define KEYMAP_BITS    8
+#define KEYMAP_MAX_KEY 37  // longest key; anything longer can't match
+
+static const map_entry MAP[] = {
+    { "paper", 5, "paper", 5, REGEX_NONE },
+    { "accession number", 16, "accession-number", 16, REGEX_NONE },
+    { "conformed submission type", 25, "type", 4, REGEX_NONE },
+    { "public document count", 21, "public-document-count", 21, REGEX_NONE },
+    { "public document_count", 21, "public-document-count", 21, REGEX_NONE },
+    { "conformed period of report", 26, "period", 6, REGEX_NONE },
+    { "filed as of date", 16, "filing-date", 11, REGEX_NONE },
+    { "date as of change", 17, "date-of-filing-date-change", 26, REGEX_NONE },
+    { "effectiveness date", 18, "effectiveness-date", 18, REGEX_NONE },
+    { "filer", 5, "filer", 5, REGEX_NONE },
+    { "company data", 12, "company-data", 12, REGEX_NONE },
+    { "company conformed name", 22, "conformed-name", 14, REGEX_NONE },
+    { "central index key", 17, "cik", 3, REGEX_NONE },
+    { "state of incorporation", 22, "state-of-incorporation", 22, REGEX_NONE },
+    { "fiscal year end", 15, "fiscal-year-end", 15, REGEX_NONE },
+    { "filing values", 13, "filing-values", 13, REGEX_NONE },
+    { "form type", 9, "form-type", 9, REGEX_NONE },
+    { "sec act", 7, "act", 3, REGEX_SEC_ACT },
+    { "sec file number", 15, "file-number", 11, REGEX_NONE },
+    { "film number", 11, "film-number", 11, REGEX_NONE },
+    { "business address", 16, "business-address", 16, REGEX_NONE },
+    { "street 1", 8, "street1", 7, REGEX_NONE },
+    { "city", 4, "city", 4, REGEX_NONE },
+    { "state", 5, "state", 5, REGEX_NONE },
+    { "zip", 3, "zip", 3, REGEX_NONE },
+    { "business phone", 14, "phone", 5, REGEX_NONE },
+    { "mail address", 12, "mail-address", 12, REGEX_NONE },
+    { "former company", 14, "former-company", 14, REGEX_NONE },
+    { "former conformed name", 21, "former-conformed-name", 21, REGEX_NONE },
+    { "date of name change", 19, "date-changed", 12, REGEX_NONE },
+    { "sros", 4, "sros", 4, REGEX_NONE },
+    { "subject company", 15, "subject-company", 15, REGEX_NONE },
+    { "standard industrial classification", 34, "assigned-sic", 12, REGEX_SIC },
+    { "irs number", 10, "irs-number", 10, REGEX_NONE },
+    { "filed by", 8, "filed-by", 8, REGEX_NONE },
+    { "street 2", 8, "street2", 7, REGEX_NONE },
+    { "items", 5, "items", 5, REGEX_NONE },
+    { "group members", 13, "group-members", 13, REGEX_NONE },
+    { "organization name", 17, "organization-name", 17, REGEX_NONE },
+    { "recieved date", 13, "recieved-date", 13, REGEX_NONE },
+    { "action date", 11, "action-date", 11, REGEX_NONE },
+    { "non us state territory", 22, "non-us-state-territory", 22, REGEX_NONE },
+    { "address is a non us location", 28, "address-is-a-non-us-location", 28, REGEX_NONE },
+    { "ein", 3, "ein", 3, REGEX_NONE },
+    { "class-contract-ticker-symbol", 28, "class-contract-ticker-symbol", 28, REGEX_NONE },
+    { "class-contract-name", 19, "class-contract-name", 19, REGEX_NONE },
+    { "class-contract-id", 17, "class-contract-id", 17, REGEX_NONE },
+    { "sec-document", 12, "sec-document", 12, REGEX_NONE },
+    { "sec-header", 10, "sec-header", 10, REGEX_NONE },
+    { "acceptance-datetime", 19, "acceptance-datetime", 19, REGEX_NONE },
+    { "series-and-classes-contracts-data", 33, "series-and-classes-contracts-data", 33, REGEX_NONE },
+    { "existing-series-and-classes-contracts", 37, "existing-series-and-classes-contracts", 37, REGEX_NONE },
+    { "merger-series-and-classes-contracts", 35, "merger-series-and-classes-contracts", 35, REGEX_NONE },
+    { "new-series-and-classes-contracts", 32, "new-series-and-classes-contracts", 32, REGEX_NONE },
+    { "series", 6, "series", 6, REGEX_NONE },
+    { "owner-cik", 9, "owner-cik", 9, REGEX_NONE },
+    { "series-id", 9, "series-id", 9, REGEX_NONE },
+    { "series-name", 11, "series-name", 11, REGEX_NONE },
+    { "acquiring-data", 14, "acquiring-data", 14, REGEX_NONE },
+    { "target-data", 11, "target-data", 11, REGEX_NONE },
+    { "new-classes-contracts", 21, "new-classes-contracts", 21, REGEX_NONE },
+    { "new-series", 10, "new-series", 10, REGEX_NONE },
+    { "relationship", 12, "relationship", 12, REGEX_NONE },
+};
+
+// MAP index + 1 per hash slot, 0 = empty
+static const uint8_t KEYMAP_SLOTS[256] = {
+     1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 21,  0, 41,  0,
+    39, 49,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 29,  0, 13, 46,
+     0, 24,  0,  0,  4,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  2,  0,  0,  0,  0,  0,  0,  0, 44, 17,  0,
+     0,  0, 58, 53,  0, 12,  0,  0,  5,  0,  0,  0, 28,  0,  0,  0,
+     0,  0, 56,  0,  0,  0,  0,  0,  0,  0,  0, 36,  0,  0, 22,  0,
+     0,  0,  0, 19,  0,  0,  0, 30, 14, 31,  0, 34,  0,  0, 55, 57,
+     0,  0,  0,  0,  0,  7, 37,  0,  0,  0,  0,  0,  0,  0,  6,  0,
+     0,  0,  0,  0, 63,  0, 43,  0, 40, 18,  0,  0,  0, 27, 54,  0,
+     0, 50,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 32,  0,
+     0,  0,  0,  0,  0,  0,  0, 25,  0, 47, 62,  0,  0,  0, 11,  0,
+     0,  0,  0, 38,  0,  0,  0, 23,  0,  0,  0, 52,  0,  0,  0,  0,
+    33,  0,  0,  0,  0, 48,  0,  0,  0,  0,  0, 16,  0,  0,  0, 35,
+     9,  0,  0,  0,  3,  0, 60, 26,  0,  0,  0, 15,  0,  0,  0, 42,
+     0,  0,  0,  0, 59,  0, 61,  0,  8,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0, 20,  0, 10,  0,  0,  0,  0, 45, 51,
+};
+
+#endif
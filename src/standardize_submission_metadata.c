@@ -19,32 +19,122 @@ static inline uint8_t to_lower_ascii(uint8_t c) {
     return c;
 }
 
-static int arena_ensure(standardized_submission_metadata *out, size_t extra) {
-    if (out->arena_len + extra <= out->arena_cap) return 1;
-    size_t new_cap = out->arena_cap ? out->arena_cap * 2 : 1024;
-    while (new_cap < out->arena_len + extra) new_cap *= 2;
-    uint8_t *tmp = (uint8_t *)realloc(out->arena, new_cap);
-    if (!tmp) return 0;
-    out->arena = tmp;
-    out->arena_cap = new_cap;
-    return 1;
+// ---------------------------------------------------------------------------
+// String arena -- a chain of blocks filled in order. Blocks never move or
+// grow, so spans handed out for earlier events stay valid as later ones are
+// appended. The first block is sized from the input (arena_estimate) and
+// holds a typical header on its own; anything past it chains a new block,
+// twice the size of the one before.
+// ---------------------------------------------------------------------------
+struct std_arena_block {
+    std_arena_block *next;
+    size_t           cap;
+    size_t           used;
+    // data follows
+};
+
+#define STD_ARENA_BLOCK_MIN 1024u
+
+static inline uint8_t *block_data(std_arena_block *b) {
+    return (uint8_t *)(b + 1);
+}
+
+static std_arena_block *block_new(const sgml_allocator *alloc, size_t cap) {
+    std_arena_block *b = (std_arena_block *)sgml_mem_alloc(alloc, sizeof(std_arena_block) + cap);
+    if (!b) return NULL;
+    b->next = NULL;
+    b->cap  = cap;
+    b->used = 0;
+    return b;
+}
+
+static void arena_free_blocks(const sgml_allocator *alloc, std_arena_block *b) {
+    while (b) {
+        std_arena_block *next = b->next;
+        sgml_mem_free(alloc, b);
+        b = next;
+    }
+}
+
+// Room for need bytes, not yet used; arena_commit takes what was written.
+// Blocks after the current one are left over from an earlier call: reuse
+// the next one if it is big enough, otherwise replace it.
+static uint8_t *arena_reserve(standardized_submission_metadata *out, size_t need) {
+    std_arena_block *b = out->arena_cur;
+    if (b && b->cap - b->used >= need) return block_data(b) + b->used;
+
+    std_arena_block *next = b ? b->next : out->arena;
+    if (next && next->cap >= need) {
+        b = next;
+    } else {
+        // Grow geometrically so a header far past the estimate is a few
+        // blocks, not a chain of minimum-sized ones
+        size_t cap = b ? b->cap * 2 : 0;
+        if (cap < STD_ARENA_BLOCK_MIN) cap = STD_ARENA_BLOCK_MIN;
+        if (cap < need) cap = need;
+        std_arena_block *nb = block_new(&out->alloc, cap);
+        if (!nb) return NULL;
+        nb->next = next ? next->next : NULL;
+        if (next) sgml_mem_free(&out->alloc, next);
+        if (b) b->next = nb;
+        else   out->arena = nb;
+        b = nb;
+    }
+    b->used = 0;
+    out->arena_cur = b;
+    return block_data(b);
+}
+
+static inline void arena_commit(standardized_submission_metadata *out, size_t len) {
+    out->arena_cur->used += len;
 }
 
 static byte_span arena_append(standardized_submission_metadata *out,
                               const uint8_t *src, size_t len) {
     if (len == 0 || !src) return (byte_span){0};
-    if (!arena_ensure(out, len)) return (byte_span){0};
-    uint8_t *dst = out->arena + out->arena_len;
+    uint8_t *dst = arena_reserve(out, len);
+    if (!dst) return (byte_span){0};
     memcpy(dst, src, len);
-    out->arena_len += len;
+    arena_commit(out, len);
     return (byte_span){ dst, len };
 }
 
+// Key and value bytes plus a little slack. Mapped keys are mostly shorter
+// than their source and values only shrink, so this is nearly always
+// enough for one block, without reserving for every key's worst case.
+static size_t arena_estimate(const submission_metadata *m) {
+    size_t total = 0;
+    for (size_t i = 0; i < m->count; i++) {
+        total += m->events[i].key.len;
+        if (m->events[i].type == SUB_EVENT_KEYVAL) total += m->events[i].value.len;
+    }
+    return total + total / 16 + 64;
+}
+
+// Starts an empty arena of at least estimate bytes in one block, keeping the
+// existing first block (and the chain after it) when that is big enough.
+// Nothing points into the arena at this point.
+static int arena_begin(standardized_submission_metadata *out, size_t estimate) {
+    if (out->arena && out->arena->cap < estimate) {
+        arena_free_blocks(&out->alloc, out->arena);
+        out->arena = NULL;
+    }
+    if (!out->arena) {
+        out->arena = block_new(&out->alloc, estimate > STD_ARENA_BLOCK_MIN ? estimate : STD_ARENA_BLOCK_MIN);
+        if (!out->arena) return 0;
+    }
+    out->arena->used = 0;
+    out->arena_cur = out->arena;
+    return 1;
+}
+
 static int events_ensure(standardized_submission_metadata *out, size_t extra) {
     if (out->count + extra <= out->cap) return 1;
     size_t new_cap = out->cap ? out->cap * 2 : 128;
     while (new_cap < out->count + extra) new_cap *= 2;
-    submission_event *tmp = (submission_event *)realloc(out->events, new_cap * sizeof(submission_event));
+    submission_event *tmp = (submission_event *)sgml_mem_realloc(&out->alloc, out->events,
+                                                                 out->cap * sizeof(submission_event),
+                                                                 new_cap * sizeof(submission_event));
     if (!tmp) return 0;
     out->events = tmp;
     out->cap = new_cap;
@@ -61,86 +151,31 @@ typedef enum {
 } regex_kind;
 
 typedef struct {
-    const char *from;
+    const char *from;      // lowercase header key
+    size_t      from_len;
     const char *to;
+    size_t      to_len;
     regex_kind  rx;
 } map_entry;
 
-static const map_entry MAP[] = {
-    { "paper", "paper", REGEX_NONE },
-    { "accession number", "accession-number", REGEX_NONE },
-    { "conformed submission type", "type", REGEX_NONE },
-    { "public document count", "public-document-count", REGEX_NONE },
-    { "public document_count", "public-document-count", REGEX_NONE },
-    { "conformed period of report", "period", REGEX_NONE },
-    { "filed as of date", "filing-date", REGEX_NONE },
-    { "date as of change", "date-of-filing-date-change", REGEX_NONE },
-    { "effectiveness date", "effectiveness-date", REGEX_NONE },
-    { "filer", "filer", REGEX_NONE },
-    { "company data", "company-data", REGEX_NONE },
-    { "company conformed name", "conformed-name", REGEX_NONE },
-    { "central index key", "cik", REGEX_NONE },
-    { "state of incorporation", "state-of-incorporation", REGEX_NONE },
-    { "fiscal year end", "fiscal-year-end", REGEX_NONE },
-    { "filing values", "filing-values", REGEX_NONE },
-    { "form type", "form-type", REGEX_NONE },
-    { "sec act", "act", REGEX_SEC_ACT },
-    { "sec file number", "file-number", REGEX_NONE },
-    { "film number", "film-number", REGEX_NONE },
-    { "business address", "business-address", REGEX_NONE },
-    { "street 1", "street1", REGEX_NONE },
-    { "city", "city", REGEX_NONE },
-    { "state", "state", REGEX_NONE },
-    { "zip", "zip", REGEX_NONE },
-    { "business phone", "phone", REGEX_NONE },
-    { "mail address", "mail-address", REGEX_NONE },
-    { "former company", "former-company", REGEX_NONE },
-    { "former conformed name", "former-conformed-name", REGEX_NONE },
-    { "date of name change", "date-changed", REGEX_NONE },
-    { "sros", "sros", REGEX_NONE },
-    { "subject company", "subject-company", REGEX_NONE },
-    { "standard industrial classification", "assigned-sic", REGEX_SIC },
-    { "irs number", "irs-number", REGEX_NONE },
-    { "filed by", "filed-by", REGEX_NONE },
-    { "street 2", "street2", REGEX_NONE },
-    { "items", "items", REGEX_NONE },
-    { "group members", "group-members", REGEX_NONE },
-    { "organization name", "organization-name", REGEX_NONE },
-    { "recieved date", "recieved-date", REGEX_NONE },
-    { "action date", "action-date", REGEX_NONE },
-    { "non us state territory", "non-us-state-territory", REGEX_NONE },
-    { "address is a non us location", "address-is-a-non-us-location", REGEX_NONE },
-    { "ein", "ein", REGEX_NONE },
-    { "class-contract-ticker-symbol", "class-contract-ticker-symbol", REGEX_NONE },
-    { "class-contract-name", "class-contract-name", REGEX_NONE },
-    { "class-contract-id", "class-contract-id", REGEX_NONE },
-    { "sec-document", "sec-document", REGEX_NONE },
-    { "sec-header", "sec-header", REGEX_NONE },
-    { "acceptance-datetime", "acceptance-datetime", REGEX_NONE },
-    { "series-and-classes-contracts-data", "series-and-classes-contracts-data", REGEX_NONE },
-    { "existing-series-and-classes-contracts", "existing-series-and-classes-contracts", REGEX_NONE },
-    { "merger-series-and-classes-contracts", "merger-series-and-classes-contracts", REGEX_NONE },
-    { "new-series-and-classes-contracts", "new-series-and-classes-contracts", REGEX_NONE },
-    { "series", "series", REGEX_NONE },
-    { "owner-cik", "owner-cik", REGEX_NONE },
-    { "series-id", "series-id", REGEX_NONE },
-    { "series-name", "series-name", REGEX_NONE },
-    { "acquiring-data", "acquiring-data", REGEX_NONE },
-    { "target-data", "target-data", REGEX_NONE },
-    { "new-classes-contracts", "new-classes-contracts", REGEX_NONE },
-    { "new-series", "new-series", REGEX_NONE },
-    { "relationship", "relationship", REGEX_NONE }
-};
+// MAP and its perfect-hash slot table, generated by tools/gen_keymap.py
+#include "standardize_keymap.h"
 
+// Lowercases and hashes key in one pass, then compares against the one
+// entry its slot can hold
 static const map_entry *lookup_map(const uint8_t *key, size_t len) {
-    if (!key || len == 0) return NULL;
-    for (size_t i = 0; i < sizeof(MAP) / sizeof(MAP[0]); i++) {
-        const char *from = MAP[i].from;
-        size_t flen = strlen(from);
-        if (flen != len) continue;
-        if (memcmp(key, from, len) == 0) return &MAP[i];
+    if (!key || len == 0 || len > KEYMAP_MAX_KEY) return NULL;
+    uint8_t lower[KEYMAP_MAX_KEY];
+    uint32_t h = KEYMAP_SEED;
+    for (size_t i = 0; i < len; i++) {
+        lower[i] = to_lower_ascii(key[i]);
+        h = (h ^ lower[i]) * 16777619u;
     }
-    return NULL;
+    uint8_t slot = KEYMAP_SLOTS[h >> (32 - KEYMAP_BITS)];
+    if (!slot) return NULL;
+    const map_entry *me = &MAP[slot - 1];
+    if (me->from_len != len || memcmp(lower, me->from, len) != 0) return NULL;
+    return me;
 }
 
 // ---------------------------------------------------------------------------
@@ -184,63 +219,67 @@ static int extract_sic(byte_span value, byte_span *out) {
     return 0;
 }
 
-// Build a lowercase key for lookup (ASCII only).
-static uint8_t *build_lower_key(const uint8_t *src, size_t len, uint8_t *stack_buf, size_t stack_cap) {
-    uint8_t *buf = stack_buf;
-    if (len > stack_cap) {
-        buf = (uint8_t *)malloc(len);
-        if (!buf) return NULL;
-    }
-    for (size_t i = 0; i < len; i++) {
-        buf[i] = to_lower_ascii(src[i]);
-    }
-    return buf;
-}
-
-static void free_lower_key(uint8_t *buf, uint8_t *stack_buf) {
-    if (buf && buf != stack_buf) free(buf);
-}
-
-// Build fallback key: lowercase and replace runs of whitespace with '-'
-static uint8_t *build_fallback_key(const uint8_t *src, size_t len, size_t *out_len) {
-    if (!out_len) return NULL;
-    if (!src || len == 0) { *out_len = 0; return NULL; }
-    uint8_t *buf = (uint8_t *)malloc(len ? len : 1);
-    if (!buf) { *out_len = 0; return NULL; }
+// Fallback key: lowercase, runs of whitespace become one '-'. Writes at most
+// len bytes to dst and returns the count.
+static size_t fold_key(uint8_t *dst, const uint8_t *src, size_t len) {
     size_t w = 0;
     int in_ws = 0;
     for (size_t i = 0; i < len; i++) {
         uint8_t c = to_lower_ascii(src[i]);
         if (is_space(c)) {
             if (!in_ws) {
-                buf[w++] = '-';
+                dst[w++] = '-';
                 in_ws = 1;
             }
         } else {
-            buf[w++] = c;
+            dst[w++] = c;
             in_ws = 0;
         }
     }
-    *out_len = w;
-    return buf;
+    return w;
+}
+
+// Standardized key written straight into the arena: '/' if the source had
+// one, then the mapped name or the folded key
+static byte_span arena_put_key(standardized_submission_metadata *out, const uint8_t *src, size_t len,
+                               int has_slash, const map_entry *me) {
+    uint8_t *dst = arena_reserve(out, (size_t)has_slash + (me ? me->to_len : len));
+    if (!dst) return (byte_span){0};
+    size_t w = 0;
+    if (has_slash) dst[w++] = '/';
+    if (me) {
+        memcpy(dst + w, me->to, me->to_len);
+        w += me->to_len;
+    } else {
+        w += fold_key(dst + w, src, len);
+    }
+    arena_commit(out, w);
+    return (byte_span){ dst, w };
 }
 
 // ---------------------------------------------------------------------------
 // API
 // ---------------------------------------------------------------------------
-standardized_submission_metadata standardize_submission_metadata(const submission_metadata *m) {
-    standardized_submission_metadata out;
-    memset(&out, 0, sizeof(out));
-    out.status = SGML_STATUS_OK;
-    if (!m || m->count == 0) return out;
+sgml_status standardize_submission_metadata_into(standardized_submission_metadata *outp,
+                                                 const submission_metadata *m) {
+    standardized_submission_metadata out = *outp;
+    out.count     = 0;
+    out.arena_cur = NULL;
+    out.status    = SGML_STATUS_OK;
+    if (!m || m->count == 0) {
+        *outp = out;
+        return out.status;
+    }
     if (m->status != SGML_STATUS_OK) {
         out.status = m->status;
-        return out;
+        *outp = out;
+        return out.status;
     }
 
-    if (!events_ensure(&out, m->count)) {
+    if (!events_ensure(&out, m->count) || !arena_begin(&out, arena_estimate(m))) {
         out.status = SGML_STATUS_OOM;
-        return out;
+        *outp = out;
+        return out.status;
     }
 
     for (size_t i = 0; i < m->count; i++) {
@@ -261,84 +300,18 @@ standardized_submission_metadata standardize_submission_metadata(const submissio
             klen--;
         }
 
+        // One lookup serves both the key and the value extractor
+        const map_entry *me = lookup_map(kptr, klen);
+
         byte_span key_out = {0};
         if (klen > 0 && kptr) {
-            uint8_t stack_buf[256];
-            uint8_t *lower = build_lower_key(kptr, klen, stack_buf, sizeof(stack_buf));
-            if (lower) {
-                const map_entry *me = lookup_map(lower, klen);
-                if (me) {
-                    size_t out_len = strlen(me->to);
-                    if (has_slash) {
-                        size_t total = out_len + 1;
-                        uint8_t *tmp = (uint8_t *)malloc(total);
-                        if (tmp) {
-                            tmp[0] = '/';
-                            memcpy(tmp + 1, me->to, out_len);
-                            key_out = arena_append(&out, tmp, total);
-                            free(tmp);
-                            if (key_out.ptr == NULL && key_out.len == 0) {
-                                out.status = SGML_STATUS_OOM;
-                                free_lower_key(lower, stack_buf);
-                                break;
-                            }
-                        } else {
-                            out.status = SGML_STATUS_OOM;
-                            free_lower_key(lower, stack_buf);
-                            break;
-                        }
-                    } else {
-                        key_out = arena_append(&out, (const uint8_t *)me->to, out_len);
-                        if (key_out.ptr == NULL && key_out.len == 0) {
-                            out.status = SGML_STATUS_OOM;
-                            free_lower_key(lower, stack_buf);
-                            break;
-                        }
-                    }
-                } else {
-                    size_t fallback_len = 0;
-                    uint8_t *fallback = build_fallback_key(kptr, klen, &fallback_len);
-                    if (fallback) {
-                        if (has_slash) {
-                            size_t total = fallback_len + 1;
-                            uint8_t *tmp = (uint8_t *)malloc(total);
-                            if (tmp) {
-                                tmp[0] = '/';
-                                memcpy(tmp + 1, fallback, fallback_len);
-                                key_out = arena_append(&out, tmp, total);
-                                free(tmp);
-                                if (key_out.ptr == NULL && key_out.len == 0) {
-                                    out.status = SGML_STATUS_OOM;
-                                    free(fallback);
-                                    free_lower_key(lower, stack_buf);
-                                    break;
-                                }
-                            } else {
-                                out.status = SGML_STATUS_OOM;
-                                free(fallback);
-                                free_lower_key(lower, stack_buf);
-                                break;
-                            }
-                        } else {
-                            key_out = arena_append(&out, fallback, fallback_len);
-                            if (key_out.ptr == NULL && key_out.len == 0) {
-                                out.status = SGML_STATUS_OOM;
-                                free(fallback);
-                                free_lower_key(lower, stack_buf);
-                                break;
-                            }
-                        }
-                        free(fallback);
-                    }
-                }
-                free_lower_key(lower, stack_buf);
-            }
+            key_out = arena_put_key(&out, kptr, klen, has_slash, me);
         } else if (key_in.len > 0 && key_in.ptr) {
             key_out = arena_append(&out, key_in.ptr, key_in.len);
-            if (key_out.ptr == NULL && key_out.len == 0) {
-                out.status = SGML_STATUS_OOM;
-                break;
-            }
+        }
+        if (key_in.len > 0 && key_in.ptr && !key_out.ptr) {
+            out.status = SGML_STATUS_OOM;
+            break;
         }
         new_ev.key = key_out;
 
@@ -349,20 +322,10 @@ standardized_submission_metadata standardize_submission_metadata(const submissio
             byte_span extracted = {0};
             int used_extract = 0;
 
-            if (klen > 0 && kptr) {
-                uint8_t stack_buf[256];
-                uint8_t *lower = build_lower_key(kptr, klen, stack_buf, sizeof(stack_buf));
-                if (lower) {
-                    const map_entry *me = lookup_map(lower, klen);
-                    if (me && me->rx != REGEX_NONE) {
-                        if (me->rx == REGEX_SEC_ACT) {
-                            used_extract = extract_sec_act(val, &extracted);
-                        } else if (me->rx == REGEX_SIC) {
-                            used_extract = extract_sic(val, &extracted);
-                        }
-                    }
-                    free_lower_key(lower, stack_buf);
-                }
+            if (me && me->rx == REGEX_SEC_ACT) {
+                used_extract = extract_sec_act(val, &extracted);
+            } else if (me && me->rx == REGEX_SIC) {
+                used_extract = extract_sic(val, &extracted);
             }
 
             if (used_extract) {
@@ -380,17 +343,30 @@ standardized_submission_metadata standardize_submission_metadata(const submissio
         out.events[out.count++] = new_ev;
     }
 
+    *outp = out;
+    return out.status;
+}
+
+standardized_submission_metadata standardize_submission_metadata_ex(const submission_metadata *m,
+                                                                    const sgml_allocator *alloc) {
+    standardized_submission_metadata out;
+    memset(&out, 0, sizeof(out));
+    if (alloc) out.alloc = *alloc;
+    standardize_submission_metadata_into(&out, m);
     return out;
 }
 
+standardized_submission_metadata standardize_submission_metadata(const submission_metadata *m) {
+    return standardize_submission_metadata_ex(m, NULL);
+}
+
 void free_standardized_submission_metadata(standardized_submission_metadata *m) {
     if (!m) return;
-    free(m->events);
-    free(m->arena);
+    sgml_mem_free(&m->alloc, m->events);
+    arena_free_blocks(&m->alloc, m->arena);
     m->events = NULL;
     m->arena = NULL;
+    m->arena_cur = NULL;
     m->count = 0;
     m->cap = 0;
-    m->arena_len = 0;
-    m->arena_cap = 0;
 }
@@ -6,19 +6,32 @@
 
 #include "secsgml.h"
 
+// String storage blocks, see standardize_submission_metadata.c
+typedef struct std_arena_block std_arena_block;
+
 // Standardized submission metadata. Owns its events array and string arena.
+// Event spans point into the arena, whose blocks never move.
 typedef struct {
     submission_event *events;
     size_t count;
     size_t cap;
-    uint8_t *arena;
-    size_t arena_len;
-    size_t arena_cap;
+    std_arena_block *arena;      // first block
+    std_arena_block *arena_cur;  // block being filled
     sgml_status status;
+    sgml_allocator alloc;  // owner of events and arena
 } standardized_submission_metadata;
 
 // Returns a standardized copy of submission metadata. Does not mutate input.
 standardized_submission_metadata standardize_submission_metadata(const submission_metadata *m);
+standardized_submission_metadata standardize_submission_metadata_ex(const submission_metadata *m,
+                                                                    const sgml_allocator *alloc);
 void free_standardized_submission_metadata(standardized_submission_metadata *m);
 
+// Same as above, but reuses the events array and arena already held by out
+// and allocates from out->alloc. Both are sized from m before the first
+// event, so a call normally allocates at most twice, and not at all once
+// they fit.
+sgml_status standardize_submission_metadata_into(standardized_submission_metadata *out,
+                                                 const submission_metadata *m);
+
 #endif
@@ -1,289 +1,279 @@
 #include "uudecode.h"
+#include "simd.h"
+#include "sgml_thread.h"
 #include <stdint.h>
 #include <stddef.h>
 #include <string.h>
 
+#if defined(SGML_X86_DISPATCH)
+#include <immintrin.h>
+#elif defined(SGML_NEON_DISPATCH)
+#include <arm_neon.h>
+#endif
+
 // ---------------------------------------------------------------------------
-// SIMD path selection: AVX2 > SSE2 > NEON > scalar
+// SIMD tiers: AVX-512 VBMI > AVX2 > SSSE3 > SSE2 > NEON > scalar
+//
+// Each tier is a full copy of the kernels and decode loop from
+// uudecode_impl.h, so the hot loop inlines its own kernels. The tier is
+// picked at run time (see simd.h).
+//
+// AVX-512 VBMI adds a multi-line decoder on top of the AVX2 paths, SSSE3
+// replaces the SSE2 line decoder and keeps the SSE2 newline scan.
 // ---------------------------------------------------------------------------
+#define UU_CAT2(a, b) a##_##b
+#define UU_CAT(a, b) UU_CAT2(a, b)
+#define UU_FN(name) UU_CAT(name, UU_SUFFIX)
 
-#if defined(__AVX2__)
-#include <immintrin.h>
-#define UUDECODE_AVX2
+#define UU_SUFFIX scalar
+#define UU_ATTR
+#include "uudecode_impl.h"
 
-#elif defined(__SSE2__)
-#include <emmintrin.h>
+#ifdef SGML_X86_DISPATCH
+#define UU_SUFFIX sse2
+#define UU_ATTR SGML_TARGET_SSE2
 #define UUDECODE_SSE2
+#include "uudecode_impl.h"
 
-#elif defined(__ARM_NEON)
-#include <arm_neon.h>
-#define UUDECODE_NEON
+#define UU_SUFFIX ssse3
+#define UU_ATTR SGML_TARGET_SSSE3
+#define UUDECODE_SSSE3
+#define UUDECODE_SSE2
+#include "uudecode_impl.h"
 
+#define UU_SUFFIX avx2
+#define UU_ATTR SGML_TARGET_AVX2
+#define UUDECODE_AVX2
+#include "uudecode_impl.h"
+
+#define UU_SUFFIX avx512vbmi
+#define UU_ATTR SGML_TARGET_AVX512VBMI
+#define UUDECODE_AVX512VBMI
+#define UUDECODE_AVX2
+#include "uudecode_impl.h"
+#endif
+
+#ifdef SGML_NEON_DISPATCH
+#define UU_SUFFIX neon
+#define UU_ATTR
+#define UUDECODE_NEON
+#include "uudecode_impl.h"
 #endif
 
 // ---------------------------------------------------------------------------
-// Newline scan
+// Dispatch
 // ---------------------------------------------------------------------------
+typedef struct
+{
+    const uint8_t *(*find_newline)(const uint8_t *p, const uint8_t *end);
+    size_t (*decode)(const uint8_t *in, size_t in_len, uint8_t *out, size_t out_cap);
+    int (*decode_fused)(const uint8_t *in, size_t in_len, uint8_t *out, size_t out_cap,
+                        int cap_is_limit, uu_fused_state *st);
+} uu_kernels;
 
-#ifdef UUDECODE_AVX2
-static inline const uint8_t *find_newline(const uint8_t *p, const uint8_t *end)
+static const uu_kernels *uu_select(void)
 {
-    __m256i nl = _mm256_set1_epi8('\n');
-    __m256i cr = _mm256_set1_epi8('\r');
-    while (p + 32 <= end)
+    static const uu_kernels scalar = {find_newline_scalar, uudecode_scalar, uudecode_fused_scalar};
+#ifdef SGML_X86_DISPATCH
+    static const uu_kernels sse2 = {find_newline_sse2, uudecode_sse2, uudecode_fused_sse2};
+    static const uu_kernels ssse3 = {find_newline_ssse3, uudecode_ssse3, uudecode_fused_ssse3};
+    static const uu_kernels avx2 = {find_newline_avx2, uudecode_avx2, uudecode_fused_avx2};
+    static const uu_kernels avx512vbmi = {find_newline_avx512vbmi, uudecode_avx512vbmi, uudecode_fused_avx512vbmi};
+#endif
+#ifdef SGML_NEON_DISPATCH
+    static const uu_kernels neon = {find_newline_neon, uudecode_neon, uudecode_fused_neon};
+#endif
+
+    switch (sgml_simd_active())
     {
-        __m256i chunk = _mm256_loadu_si256((const __m256i *)p);
-        uint32_t mask = (uint32_t)(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, nl)) |
-                                   _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, cr)));
-        if (mask)
-            return p + __builtin_ctz(mask);
-        p += 32;
+#ifdef SGML_X86_DISPATCH
+    case SGML_SIMD_AVX512VBMI:
+        return &avx512vbmi;
+    case SGML_SIMD_AVX2:
+        return &avx2;
+    case SGML_SIMD_SSSE3:
+        return &ssse3;
+    case SGML_SIMD_SSE2:
+        return &sse2;
+#endif
+#ifdef SGML_NEON_DISPATCH
+    case SGML_SIMD_NEON:
+        return &neon;
+#endif
+    default:
+        return &scalar;
     }
-    while (p < end && *p != '\n' && *p != '\r')
-        p++;
-    return p;
 }
 
-#elif defined(UUDECODE_SSE2)
-static inline const uint8_t *find_newline(const uint8_t *p, const uint8_t *end)
+size_t uudecode(const uint8_t *in, size_t in_len, uint8_t *out, size_t out_cap)
 {
-    __m128i nl = _mm_set1_epi8('\n');
-    __m128i cr = _mm_set1_epi8('\r');
-    while (p + 16 <= end)
-    {
-        __m128i chunk = _mm_loadu_si128((const __m128i *)p);
-        uint32_t mask = (uint32_t)(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, nl)) |
-                                   _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, cr)));
-        if (mask)
-            return p + __builtin_ctz(mask);
-        p += 16;
-    }
-    while (p < end && *p != '\n' && *p != '\r')
-        p++;
-    return p;
+    return uu_select()->decode(in, in_len, out, out_cap);
 }
 
-#elif defined(UUDECODE_NEON)
-static inline const uint8_t *find_newline(const uint8_t *p, const uint8_t *end)
+int uudecode_fused(const uint8_t *in, size_t in_len, uint8_t *out, size_t out_cap,
+                   int cap_is_limit, uu_fused_state *st)
 {
-    uint8x16_t nl = vdupq_n_u8('\n');
-    uint8x16_t cr = vdupq_n_u8('\r');
-    while (p + 16 <= end)
-    {
-        uint8x16_t chunk = vld1q_u8(p);
-        uint8x16_t match = vorrq_u8(vceqq_u8(chunk, nl), vceqq_u8(chunk, cr));
-        // Collapse to 64-bit to check for any match
-        uint64_t lo, hi;
-        lo = vgetq_lane_u64(vreinterpretq_u64_u8(match), 0);
-        hi = vgetq_lane_u64(vreinterpretq_u64_u8(match), 1);
-        if (lo | hi)
-        {
-            // Find exact position scalar
-            for (int k = 0; k < 16; k++)
-            {
-                if (p[k] == '\n' || p[k] == '\r')
-                    return p + k;
-            }
-        }
-        p += 16;
-    }
-    while (p < end && *p != '\n' && *p != '\r')
-        p++;
-    return p;
+    return uu_select()->decode_fused(in, in_len, out, out_cap, cap_is_limit, st);
 }
 
-#else
-static inline const uint8_t *find_newline(const uint8_t *p, const uint8_t *end)
+uu_find_newline_fn uu_select_find_newline(void)
 {
-    while (p < end && *p != '\n' && *p != '\r')
-        p++;
-    return p;
+    return uu_select()->find_newline;
 }
-#endif
 
 // ---------------------------------------------------------------------------
-// Full line decode: 60 encoded bytes -> 45 decoded bytes
+// Parallel decode
 // ---------------------------------------------------------------------------
 
-#ifdef UUDECODE_AVX2
-static inline void decode_full_line(const uint8_t *in, uint8_t *out, size_t *out_pos)
+// Decoded size of one segment. Same length-char rules as uudecode; sets
+// *terminated if a zero-length line ends the payload inside this segment.
+static size_t segment_size(const uint8_t *p, const uint8_t *end, int *terminated)
 {
-    __m256i sub32 = _mm256_set1_epi8(32);
-    __m256i mask6 = _mm256_set1_epi8(0x3f);
-
-    uint8_t tmp[64];
-
-    // Two 32-byte loads cover all 60 encoded bytes (second load overlaps)
-    __m256i c0 = _mm256_and_si256(_mm256_sub_epi8(_mm256_loadu_si256((const __m256i *)(in)), sub32), mask6);
-    __m256i c1 = _mm256_and_si256(_mm256_sub_epi8(_mm256_loadu_si256((const __m256i *)(in + 32)), sub32), mask6);
-    _mm256_storeu_si256((__m256i *)tmp, c0);
-    _mm256_storeu_si256((__m256i *)(tmp + 32), c1);
-
-    uint8_t *o = out + *out_pos;
-    for (int g = 0; g < 15; g++)
+    const uu_kernels *k = uu_select();
+    size_t total = 0;
+    *terminated = 0;
+    while (p < end)
     {
-        uint8_t da = tmp[g * 4 + 0], db = tmp[g * 4 + 1], dc = tmp[g * 4 + 2], dd = tmp[g * 4 + 3];
-        o[g * 3 + 0] = (da << 2) | (db >> 4);
-        o[g * 3 + 1] = (db << 4) | (dc >> 2);
-        o[g * 3 + 2] = (dc << 6) | dd;
+        if (*p == '\n' || *p == '\r')
+        {
+            p++;
+            continue;
+        }
+        int nbytes = (*p - 32) & 0x3f;
+        if (nbytes == 0)
+        {
+            *terminated = 1;
+            break;
+        }
+        total += (size_t)nbytes;
+        p = k->find_newline(p + 1, end);
     }
-    *out_pos += 45;
+    return total;
 }
 
-#elif defined(UUDECODE_SSE2)
-static inline void decode_full_line(const uint8_t *in, uint8_t *out, size_t *out_pos)
+size_t uudecode_size(const uint8_t *in, size_t in_len)
 {
-    __m128i sub32 = _mm_set1_epi8(32);
-    __m128i mask6 = _mm_set1_epi8(0x3f);
-
-    uint8_t tmp[64];
-
-    // Four 16-byte loads cover 60 bytes (last load at offset 44, overlaps by 4)
-    __m128i c0 = _mm_and_si128(_mm_sub_epi8(_mm_loadu_si128((const __m128i *)(in)), sub32), mask6);
-    __m128i c1 = _mm_and_si128(_mm_sub_epi8(_mm_loadu_si128((const __m128i *)(in + 16)), sub32), mask6);
-    __m128i c2 = _mm_and_si128(_mm_sub_epi8(_mm_loadu_si128((const __m128i *)(in + 32)), sub32), mask6);
-    __m128i c3 = _mm_and_si128(_mm_sub_epi8(_mm_loadu_si128((const __m128i *)(in + 44)), sub32), mask6);
-    _mm_storeu_si128((__m128i *)tmp, c0);
-    _mm_storeu_si128((__m128i *)(tmp + 16), c1);
-    _mm_storeu_si128((__m128i *)(tmp + 32), c2);
-    _mm_storeu_si128((__m128i *)(tmp + 44), c3);
-
-    uint8_t *o = out + *out_pos;
-    for (int g = 0; g < 15; g++)
-    {
-        uint8_t da = tmp[g * 4 + 0], db = tmp[g * 4 + 1], dc = tmp[g * 4 + 2], dd = tmp[g * 4 + 3];
-        o[g * 3 + 0] = (da << 2) | (db >> 4);
-        o[g * 3 + 1] = (db << 4) | (dc >> 2);
-        o[g * 3 + 2] = (dc << 6) | dd;
-    }
-    *out_pos += 45;
+    int terminated;
+    return segment_size(in, in + in_len, &terminated);
 }
 
-#elif defined(UUDECODE_NEON)
-static inline void decode_full_line(const uint8_t *in, uint8_t *out, size_t *out_pos)
+// First line start at or after p
+static const uint8_t *next_line_start(const uint8_t *p, const uint8_t *end)
 {
-    uint8x16_t sub32 = vdupq_n_u8(32);
-    uint8x16_t mask6 = vdupq_n_u8(0x3f);
-
-    uint8_t tmp[64];
+    p = uu_select()->find_newline(p, end);
+    if (p < end && *p == '\r')
+        p++;
+    if (p < end && *p == '\n')
+        p++;
+    return p;
+}
 
-    // Four 16-byte loads
-    vst1q_u8(tmp, vandq_u8(vsubq_u8(vld1q_u8(in), sub32), mask6));
-    vst1q_u8(tmp + 16, vandq_u8(vsubq_u8(vld1q_u8(in + 16), sub32), mask6));
-    vst1q_u8(tmp + 32, vandq_u8(vsubq_u8(vld1q_u8(in + 32), sub32), mask6));
-    vst1q_u8(tmp + 44, vandq_u8(vsubq_u8(vld1q_u8(in + 44), sub32), mask6));
+typedef struct
+{
+    uu_plan *plan;
+    uint8_t *out;
+    size_t out_cap;
+    size_t seg;
+    int terminated;
+} uu_segment_job;
+
+static SGML_THREAD_FUNC(size_segment_main, arg)
+{
+    uu_segment_job *job = (uu_segment_job *)arg;
+    uu_plan *plan = job->plan;
+    const uint8_t *s = plan->seg_start[job->seg];
+    plan->seg_size[job->seg] = segment_size(s, s + plan->seg_len[job->seg], &job->terminated);
+    return SGML_THREAD_RETURN;
+}
 
-    uint8_t *o = out + *out_pos;
-    for (int g = 0; g < 15; g++)
+static SGML_THREAD_FUNC(decode_segment_main, arg)
+{
+    uu_segment_job *job = (uu_segment_job *)arg;
+    const uu_plan *plan = job->plan;
+    size_t off = plan->seg_out[job->seg];
+    if (off < job->out_cap)
     {
-        uint8_t da = tmp[g * 4 + 0], db = tmp[g * 4 + 1], dc = tmp[g * 4 + 2], dd = tmp[g * 4 + 3];
-        o[g * 3 + 0] = (da << 2) | (db >> 4);
-        o[g * 3 + 1] = (db << 4) | (dc >> 2);
-        o[g * 3 + 2] = (dc << 6) | dd;
+        size_t cap = plan->seg_size[job->seg];
+        if (cap > job->out_cap - off)
+            cap = job->out_cap - off;
+        uudecode(plan->seg_start[job->seg], plan->seg_len[job->seg], job->out + off, cap);
     }
-    *out_pos += 45;
+    return SGML_THREAD_RETURN;
 }
 
-#else
-static inline void decode_full_line(const uint8_t *in, uint8_t *out, size_t *out_pos)
+// Run fn over every segment, one thread each; the caller takes segment 0.
+// Segments whose thread fails to start run on the caller afterwards.
+static void run_segments(uu_segment_job *jobs, size_t n, sgml_thread_fn fn)
 {
-    uint8_t *o = out + *out_pos;
-    for (int g = 0; g < 15; g++)
+    sgml_thread threads[UU_MAX_SEGMENTS];
+    int started[UU_MAX_SEGMENTS] = {0};
+    for (size_t i = 1; i < n; i++)
+        started[i] = sgml_thread_start(&threads[i], fn, &jobs[i]);
+    fn(&jobs[0]);
+    for (size_t i = 1; i < n; i++)
     {
-        uint8_t da = (in[g * 4 + 0] - 32) & 0x3f;
-        uint8_t db = (in[g * 4 + 1] - 32) & 0x3f;
-        uint8_t dc = (in[g * 4 + 2] - 32) & 0x3f;
-        uint8_t dd = (in[g * 4 + 3] - 32) & 0x3f;
-        o[g * 3 + 0] = (da << 2) | (db >> 4);
-        o[g * 3 + 1] = (db << 4) | (dc >> 2);
-        o[g * 3 + 2] = (dc << 6) | dd;
+        if (started[i])
+            sgml_thread_join(threads[i]);
+        else
+            fn(&jobs[i]);
     }
-    *out_pos += 45;
 }
-#endif
 
-// ---------------------------------------------------------------------------
-// Main decode loop
-// ---------------------------------------------------------------------------
-
-size_t uudecode(const uint8_t *in, size_t in_len, uint8_t *out, size_t out_cap)
+size_t uu_plan_segments(uu_plan *plan, const uint8_t *in, size_t in_len, int nthreads)
 {
-    size_t i = 0;
-    size_t out_pos = 0;
-    const uint8_t *buf = in;
     const uint8_t *end = in + in_len;
-
-    while (i < in_len)
+    if (nthreads < 1)
+        nthreads = 1;
+    if (nthreads > UU_MAX_SEGMENTS)
+        nthreads = UU_MAX_SEGMENTS;
+
+    // Equal byte ranges, each moved forward to the next line start
+    size_t n = 0;
+    const uint8_t *seg = in;
+    for (int k = 1; k <= nthreads && seg < end; k++)
     {
-        uint8_t len_char = buf[i];
-
-        // Skip blank lines / CRLF
-        if (len_char == '\n' || len_char == '\r')
-        {
-            i++;
-            continue;
-        }
-
-        // Zero-length line = end of uuencoded block
-        int nbytes = (len_char - 32) & 0x3f;
-        if (nbytes == 0)
-            break;
-
-        i++; // consume length char
-
-        // Find end of line (SIMD-accelerated)
-        const uint8_t *line_start = buf + i;
-        const uint8_t *line_end = find_newline(line_start, end);
-        size_t line_len = (size_t)(line_end - line_start);
-
-        // Advance i past line and newline
-        i += line_len;
-        if (i < in_len && buf[i] == '\r')
-            i++;
-        if (i < in_len && buf[i] == '\n')
-            i++;
-
-        int out_full = 0;
-        if (out_pos + (size_t)nbytes > out_cap)
-        {
-            nbytes = (int)(out_cap - out_pos);
-            out_full = 1;
-        }
-        if (nbytes <= 0)
-            return out_pos;
-
-        // --- FAST PATH: full line, >= 60 encoded chars ---
-        if (!out_full && len_char == 'M' && line_len >= 60 && (line_start + 64 <= end) &&
-            (out_pos + 45 <= out_cap))
-        {
-            decode_full_line(line_start, out, &out_pos);
+        const uint8_t *cut = (k == nthreads) ? end : next_line_start(in + in_len / (size_t)nthreads * (size_t)k, end);
+        if (cut <= seg)
             continue;
-        }
-
-        // --- SLOW PATH: partial or short line ---
-        const uint8_t *p = line_start;
-        int remaining = nbytes;
-        uint32_t leftchar = 0;
-        int leftbits = 0;
-        while (remaining > 0)
+        plan->seg_start[n] = seg;
+        plan->seg_len[n] = (size_t)(cut - seg);
+        n++;
+        seg = cut;
+    }
+    plan->seg_count = n;
+    plan->total = 0;
+    if (n == 0)
+        return 0;
+
+    uu_segment_job jobs[UU_MAX_SEGMENTS];
+    for (size_t i = 0; i < n; i++)
+        jobs[i] = (uu_segment_job){plan, NULL, 0, i, 0};
+    run_segments(jobs, n, size_segment_main);
+
+    // Prefix sum; a zero-length line ends the payload, later segments are dropped
+    size_t off = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        plan->seg_out[i] = off;
+        off += plan->seg_size[i];
+        if (jobs[i].terminated)
         {
-            uint8_t ch = (p < line_end) ? ((*p++ - 32) & 0x3f) : 0;
-            leftchar = (leftchar << 6) | ch;
-            leftbits += 6;
-            if (leftbits >= 8)
-            {
-                leftbits -= 8;
-                if (out_pos >= out_cap)
-                    return out_pos;
-                out[out_pos++] = (leftchar >> leftbits) & 0xff;
-                leftchar &= (1 << leftbits) - 1;
-                remaining--;
-            }
+            plan->seg_count = i + 1;
+            break;
         }
-
-        if (out_full)
-            return out_pos;
     }
+    plan->total = off;
+    return off;
+}
 
-    return out_pos;
+size_t uudecode_planned(const uu_plan *plan, uint8_t *out, size_t out_cap)
+{
+    size_t n = plan->seg_count;
+    if (n == 0)
+        return 0;
+    uu_segment_job jobs[UU_MAX_SEGMENTS];
+    for (size_t i = 0; i < n; i++)
+        jobs[i] = (uu_segment_job){(uu_plan *)plan, out, out_cap, i, 0};
+    run_segments(jobs, n, decode_segment_main);
+    return plan->total < out_cap ? plan->total : out_cap;
 }
@@ -8,4 +8,61 @@
 // Returns number of bytes written (may be less than out_cap if input is larger).
 size_t uudecode(const uint8_t *in, size_t in_len, uint8_t *out, size_t out_cap);
 
+// Exact number of bytes uudecode would write for in, without decoding.
+size_t uudecode_size(const uint8_t *in, size_t in_len);
+
+// Newline scan of the active SIMD tier: first '\n' or '\r' in [p, end), or
+// end. Resolve once and keep the pointer.
+typedef const uint8_t *(*uu_find_newline_fn)(const uint8_t *p, const uint8_t *end);
+uu_find_newline_fn uu_select_find_newline(void);
+
+// ---------------------------------------------------------------------------
+// Fused decode: finds the "end" line, sizes and decodes in one pass
+//
+// in spans from the first encoded line to the end of the text. Decoding
+// follows uudecode's rules and stops at a zero-length line or the "end" line;
+// enc_len is the offset of the "end" line (in_len if there is none), even
+// when decoding stopped earlier.
+//
+// Returns UU_FUSED_FULL when the next line does not fit in out_cap: grow out
+// (keeping its contents) and call again with the same state. With
+// cap_is_limit set, out_cap is final: the line that crosses it is decoded
+// partially and truncated is set.
+// ---------------------------------------------------------------------------
+#define UU_FUSED_DONE 0
+#define UU_FUSED_FULL 1
+
+typedef struct {
+    size_t in_pos;     // resume offset, always a line start
+    size_t out_pos;    // bytes written to out so far
+    size_t enc_len;    // offset of the "end" line, set on UU_FUSED_DONE
+    int    truncated;  // payload continued past a final out_cap
+} uu_fused_state;
+
+int uudecode_fused(const uint8_t *in, size_t in_len, uint8_t *out, size_t out_cap,
+                   int cap_is_limit, uu_fused_state *st);
+
+// ---------------------------------------------------------------------------
+// Parallel decode of one large payload
+//
+// uu_plan_segments cuts the input at line boundaries into one segment per
+// thread and sums each segment's length chars concurrently. The prefix sum of
+// those sizes is each segment's output offset, so uudecode_planned can decode
+// all segments at once into the same buffer. Output is identical to uudecode,
+// including stopping at the first zero-length line.
+// ---------------------------------------------------------------------------
+#define UU_MAX_SEGMENTS 64
+
+typedef struct {
+    size_t         seg_count;
+    const uint8_t *seg_start[UU_MAX_SEGMENTS];
+    size_t         seg_len[UU_MAX_SEGMENTS];
+    size_t         seg_size[UU_MAX_SEGMENTS];  // decoded bytes in segment
+    size_t         seg_out[UU_MAX_SEGMENTS];   // output offset of segment
+    size_t         total;                      // decoded size of whole payload
+} uu_plan;
+
+size_t uu_plan_segments(uu_plan *plan, const uint8_t *in, size_t in_len, int nthreads);
+size_t uudecode_planned(const uu_plan *plan, uint8_t *out, size_t out_cap);
+
 #endif
@@ -0,0 +1,567 @@
+// ---------------------------------------------------------------------------
+// uudecode kernels for one SIMD tier
+//
+// Included once per tier by uudecode.c. Before including, define UU_SUFFIX
+// (appended to every function name), UU_ATTR (target attribute) and the
+// UUDECODE_* flags of the tier. All of them are undefined again at the end.
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// Newline scan
+// ---------------------------------------------------------------------------
+
+#ifdef UUDECODE_AVX2
+static inline UU_ATTR const uint8_t *UU_FN(find_newline)(const uint8_t *p, const uint8_t *end)
+{
+    __m256i nl = _mm256_set1_epi8('\n');
+    __m256i cr = _mm256_set1_epi8('\r');
+    while (p + 32 <= end)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)p);
+        uint32_t mask = (uint32_t)(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, nl)) |
+                                   _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, cr)));
+        if (mask)
+            return p + __builtin_ctz(mask);
+        p += 32;
+    }
+    while (p < end && *p != '\n' && *p != '\r')
+        p++;
+    return p;
+}
+
+#elif defined(UUDECODE_SSE2)
+static inline UU_ATTR const uint8_t *UU_FN(find_newline)(const uint8_t *p, const uint8_t *end)
+{
+    __m128i nl = _mm_set1_epi8('\n');
+    __m128i cr = _mm_set1_epi8('\r');
+    while (p + 16 <= end)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)p);
+        uint32_t mask = (uint32_t)(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, nl)) |
+                                   _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, cr)));
+        if (mask)
+            return p + __builtin_ctz(mask);
+        p += 16;
+    }
+    while (p < end && *p != '\n' && *p != '\r')
+        p++;
+    return p;
+}
+
+#elif defined(UUDECODE_NEON)
+static inline UU_ATTR const uint8_t *UU_FN(find_newline)(const uint8_t *p, const uint8_t *end)
+{
+    uint8x16_t nl = vdupq_n_u8('\n');
+    uint8x16_t cr = vdupq_n_u8('\r');
+    while (p + 16 <= end)
+    {
+        uint8x16_t chunk = vld1q_u8(p);
+        uint8x16_t match = vorrq_u8(vceqq_u8(chunk, nl), vceqq_u8(chunk, cr));
+        // Collapse to 64-bit to check for any match
+        uint64_t lo, hi;
+        lo = vgetq_lane_u64(vreinterpretq_u64_u8(match), 0);
+        hi = vgetq_lane_u64(vreinterpretq_u64_u8(match), 1);
+        if (lo | hi)
+        {
+            // Find exact position scalar
+            for (int k = 0; k < 16; k++)
+            {
+                if (p[k] == '\n' || p[k] == '\r')
+                    return p + k;
+            }
+        }
+        p += 16;
+    }
+    while (p < end && *p != '\n' && *p != '\r')
+        p++;
+    return p;
+}
+
+#else
+static inline UU_ATTR const uint8_t *UU_FN(find_newline)(const uint8_t *p, const uint8_t *end)
+{
+    while (p < end && *p != '\n' && *p != '\r')
+        p++;
+    return p;
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// Full line decode: 60 encoded bytes -> 45 decoded bytes
+//
+// Vector paths repack 6-bit values in registers: maddubs merges pairs into
+// 12 bits, madd merges those into one 24-bit group per dword, and a byte
+// shuffle pulls the three output bytes of each group out big-endian. Stores
+// cover exactly 45 bytes so the fast path never writes past out_pos + 45.
+// ---------------------------------------------------------------------------
+
+#ifdef UUDECODE_AVX2
+// 8 groups of 4 six-bit values -> 24 bytes at the bottom of the register
+static inline UU_ATTR __m256i UU_FN(repack_avx2)(__m256i v)
+{
+    const __m256i shuf = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                          2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    __m256i merged = _mm256_maddubs_epi16(v, _mm256_set1_epi32(0x01400140));
+    __m256i packed = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+    packed = _mm256_shuffle_epi8(packed, shuf);
+    return _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+}
+
+static inline UU_ATTR void UU_FN(decode_full_line)(const uint8_t *in, uint8_t *out, size_t *out_pos)
+{
+    __m256i sub32 = _mm256_set1_epi8(32);
+    __m256i mask6 = _mm256_set1_epi8(0x3f);
+
+    // Two 32-byte loads cover all 60 encoded bytes (last group of the
+    // second load is past the line and dropped)
+    __m256i c0 = _mm256_and_si256(_mm256_sub_epi8(_mm256_loadu_si256((const __m256i *)(in)), sub32), mask6);
+    __m256i c1 = _mm256_and_si256(_mm256_sub_epi8(_mm256_loadu_si256((const __m256i *)(in + 32)), sub32), mask6);
+    __m256i r0 = UU_FN(repack_avx2)(c0);
+    __m256i r1 = UU_FN(repack_avx2)(c1);
+
+    uint8_t *o = out + *out_pos;
+    _mm256_storeu_si256((__m256i *)o, r0);                          // 0..31, 24..31 rewritten below
+    _mm_storeu_si128((__m128i *)(o + 24), _mm256_castsi256_si128(r1)); // 24..39
+    __m128i hi = _mm256_extracti128_si256(r1, 1);
+    uint32_t w = (uint32_t)_mm_cvtsi128_si32(hi);
+    memcpy(o + 40, &w, 4);                                          // 40..43
+    o[44] = (uint8_t)_mm_extract_epi8(hi, 4);
+    *out_pos += 45;
+}
+
+#elif defined(UUDECODE_SSSE3)
+// 4 groups of 4 six-bit values -> 12 bytes at the bottom of the register
+static inline UU_ATTR __m128i UU_FN(repack_ssse3)(__m128i v)
+{
+    const __m128i shuf = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    __m128i merged = _mm_maddubs_epi16(v, _mm_set1_epi32(0x01400140));
+    __m128i packed = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+    return _mm_shuffle_epi8(packed, shuf);
+}
+
+static inline UU_ATTR void UU_FN(decode_full_line)(const uint8_t *in, uint8_t *out, size_t *out_pos)
+{
+    __m128i sub32 = _mm_set1_epi8(32);
+    __m128i mask6 = _mm_set1_epi8(0x3f);
+
+    // Four 16-byte loads, 4 groups each (group 15 is past the line)
+    __m128i c0 = _mm_and_si128(_mm_sub_epi8(_mm_loadu_si128((const __m128i *)(in)), sub32), mask6);
+    __m128i c1 = _mm_and_si128(_mm_sub_epi8(_mm_loadu_si128((const __m128i *)(in + 16)), sub32), mask6);
+    __m128i c2 = _mm_and_si128(_mm_sub_epi8(_mm_loadu_si128((const __m128i *)(in + 32)), sub32), mask6);
+    __m128i c3 = _mm_and_si128(_mm_sub_epi8(_mm_loadu_si128((const __m128i *)(in + 48)), sub32), mask6);
+
+    // Each store's 4 spare bytes are rewritten by the next one
+    uint8_t *o = out + *out_pos;
+    _mm_storeu_si128((__m128i *)(o), UU_FN(repack_ssse3)(c0));      // 0..11
+    _mm_storeu_si128((__m128i *)(o + 12), UU_FN(repack_ssse3)(c1)); // 12..23
+    _mm_storeu_si128((__m128i *)(o + 24), UU_FN(repack_ssse3)(c2)); // 24..35
+    __m128i r3 = UU_FN(repack_ssse3)(c3);
+    _mm_storel_epi64((__m128i *)(o + 36), r3);               // 36..43
+    o[44] = (uint8_t)_mm_extract_epi16(r3, 4);
+    *out_pos += 45;
+}
+
+#elif defined(UUDECODE_SSE2)
+static inline UU_ATTR void UU_FN(decode_full_line)(const uint8_t *in, uint8_t *out, size_t *out_pos)
+{
+    __m128i sub32 = _mm_set1_epi8(32);
+    __m128i mask6 = _mm_set1_epi8(0x3f);
+
+    uint8_t tmp[64];
+
+    // Four 16-byte loads cover 60 bytes (last load at offset 44, overlaps by 4)
+    __m128i c0 = _mm_and_si128(_mm_sub_epi8(_mm_loadu_si128((const __m128i *)(in)), sub32), mask6);
+    __m128i c1 = _mm_and_si128(_mm_sub_epi8(_mm_loadu_si128((const __m128i *)(in + 16)), sub32), mask6);
+    __m128i c2 = _mm_and_si128(_mm_sub_epi8(_mm_loadu_si128((const __m128i *)(in + 32)), sub32), mask6);
+    __m128i c3 = _mm_and_si128(_mm_sub_epi8(_mm_loadu_si128((const __m128i *)(in + 44)), sub32), mask6);
+    _mm_storeu_si128((__m128i *)tmp, c0);
+    _mm_storeu_si128((__m128i *)(tmp + 16), c1);
+    _mm_storeu_si128((__m128i *)(tmp + 32), c2);
+    _mm_storeu_si128((__m128i *)(tmp + 44), c3);
+
+    uint8_t *o = out + *out_pos;
+    for (int g = 0; g < 15; g++)
+    {
+        uint8_t da = tmp[g * 4 + 0], db = tmp[g * 4 + 1], dc = tmp[g * 4 + 2], dd = tmp[g * 4 + 3];
+        o[g * 3 + 0] = (da << 2) | (db >> 4);
+        o[g * 3 + 1] = (db << 4) | (dc >> 2);
+        o[g * 3 + 2] = (dc << 6) | dd;
+    }
+    *out_pos += 45;
+}
+
+#elif defined(UUDECODE_NEON) && defined(__aarch64__)
+static inline UU_ATTR void UU_FN(decode_full_line)(const uint8_t *in, uint8_t *out, size_t *out_pos)
+{
+    // Output byte n comes from group n / 3, byte n % 3 of the group
+    static const uint8_t interleave[48] = {
+        0, 16, 32, 1, 17, 33, 2, 18, 34, 3, 19, 35, 4, 20, 36, 5,
+        21, 37, 6, 22, 38, 7, 23, 39, 8, 24, 40, 9, 25, 41, 10, 26,
+        42, 11, 27, 43, 12, 28, 44, 13, 29, 45, 14, 30, 46, 15, 31, 47};
+
+    uint8x16_t sub32 = vdupq_n_u8(32);
+    uint8x16_t mask6 = vdupq_n_u8(0x3f);
+
+    // Deinterleaving load: val[k] holds byte k of groups 0..15
+    uint8x16x4_t c = vld4q_u8(in);
+    uint8x16_t da = vandq_u8(vsubq_u8(c.val[0], sub32), mask6);
+    uint8x16_t db = vandq_u8(vsubq_u8(c.val[1], sub32), mask6);
+    uint8x16_t dc = vandq_u8(vsubq_u8(c.val[2], sub32), mask6);
+    uint8x16_t dd = vandq_u8(vsubq_u8(c.val[3], sub32), mask6);
+
+    uint8x16x3_t t;
+    t.val[0] = vorrq_u8(vshlq_n_u8(da, 2), vshrq_n_u8(db, 4));
+    t.val[1] = vorrq_u8(vshlq_n_u8(db, 4), vshrq_n_u8(dc, 2));
+    t.val[2] = vorrq_u8(vshlq_n_u8(dc, 6), dd);
+
+    uint8_t *o = out + *out_pos;
+    vst1q_u8(o, vqtbl3q_u8(t, vld1q_u8(interleave)));           // 0..15
+    vst1q_u8(o + 16, vqtbl3q_u8(t, vld1q_u8(interleave + 16))); // 16..31
+    uint8x16_t r2 = vqtbl3q_u8(t, vld1q_u8(interleave + 32));
+    vst1_u8(o + 32, vget_low_u8(r2));                           // 32..39
+    uint32_t w = vgetq_lane_u32(vreinterpretq_u32_u8(r2), 2);
+    memcpy(o + 40, &w, 4);                                      // 40..43
+    o[44] = vgetq_lane_u8(r2, 12);
+    *out_pos += 45;
+}
+
+#elif defined(UUDECODE_NEON)
+// 32-bit NEON has no vqtbl3q: subtract and mask in registers, repack scalar
+static inline UU_ATTR void UU_FN(decode_full_line)(const uint8_t *in, uint8_t *out, size_t *out_pos)
+{
+    uint8x16_t sub32 = vdupq_n_u8(32);
+    uint8x16_t mask6 = vdupq_n_u8(0x3f);
+
+    uint8_t tmp[64];
+
+    // Four 16-byte loads
+    vst1q_u8(tmp, vandq_u8(vsubq_u8(vld1q_u8(in), sub32), mask6));
+    vst1q_u8(tmp + 16, vandq_u8(vsubq_u8(vld1q_u8(in + 16), sub32), mask6));
+    vst1q_u8(tmp + 32, vandq_u8(vsubq_u8(vld1q_u8(in + 32), sub32), mask6));
+    vst1q_u8(tmp + 44, vandq_u8(vsubq_u8(vld1q_u8(in + 44), sub32), mask6));
+
+    uint8_t *o = out + *out_pos;
+    for (int g = 0; g < 15; g++)
+    {
+        uint8_t da = tmp[g * 4 + 0], db = tmp[g * 4 + 1], dc = tmp[g * 4 + 2], dd = tmp[g * 4 + 3];
+        o[g * 3 + 0] = (da << 2) | (db >> 4);
+        o[g * 3 + 1] = (db << 4) | (dc >> 2);
+        o[g * 3 + 2] = (dc << 6) | dd;
+    }
+    *out_pos += 45;
+}
+
+#else
+static inline UU_ATTR void UU_FN(decode_full_line)(const uint8_t *in, uint8_t *out, size_t *out_pos)
+{
+    uint8_t *o = out + *out_pos;
+    for (int g = 0; g < 15; g++)
+    {
+        uint8_t da = (in[g * 4 + 0] - 32) & 0x3f;
+        uint8_t db = (in[g * 4 + 1] - 32) & 0x3f;
+        uint8_t dc = (in[g * 4 + 2] - 32) & 0x3f;
+        uint8_t dd = (in[g * 4 + 3] - 32) & 0x3f;
+        o[g * 3 + 0] = (da << 2) | (db >> 4);
+        o[g * 3 + 1] = (db << 4) | (dc >> 2);
+        o[g * 3 + 2] = (dc << 6) | dd;
+    }
+    *out_pos += 45;
+}
+#endif
+
+#ifdef UUDECODE_AVX512VBMI
+// ---------------------------------------------------------------------------
+// Multi-line decode: runs of full 'M' lines, 4 per iteration
+//
+// Each line is one masked 60-byte load, a 512-bit repack and one vpermb that
+// gathers the 45 output bytes, stored with a 45-byte mask. Only lines with
+// exactly 60 encoded chars and the same line ending as the first are taken,
+// so line starts are at a fixed stride and need no newline search.
+// ---------------------------------------------------------------------------
+// Output byte n is byte 2 - n % 3 of dword n / 3
+static const uint8_t VBMI_GATHER[64] = {
+    2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, 18, 17, 16, 22,
+    21, 20, 26, 25, 24, 30, 29, 28, 34, 33, 32, 38, 37, 36, 42, 41,
+    40, 46, 45, 44, 50, 49, 48, 54, 53, 52, 58, 57, 56, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+// p points at a length char. Decodes the line if it is a plain full line:
+// 'M', exactly 60 chars, then the expected line ending. Returns 0 otherwise.
+static inline UU_ATTR int UU_FN(decode_line_vbmi)(const uint8_t *p, size_t stride, uint8_t *o, __m512i gather)
+{
+    const __mmask64 in_mask = (1ULL << 60) - 1;
+    const __mmask64 out_mask = (1ULL << 45) - 1;
+    if (p[0] != 'M' || (stride == 62 ? p[61] != '\n' : (p[61] != '\r' || p[62] != '\n')))
+        return 0;
+    __m512i v = _mm512_maskz_loadu_epi8(in_mask, p + 1);
+    if (_mm512_mask_cmpeq_epi8_mask(in_mask, v, _mm512_set1_epi8('\n')) |
+        _mm512_mask_cmpeq_epi8_mask(in_mask, v, _mm512_set1_epi8('\r')))
+        return 0;
+    v = _mm512_and_si512(_mm512_sub_epi8(v, _mm512_set1_epi8(32)), _mm512_set1_epi8(0x3f));
+    v = _mm512_maddubs_epi16(v, _mm512_set1_epi32(0x01400140));
+    v = _mm512_madd_epi16(v, _mm512_set1_epi32(0x00011000));
+    _mm512_mask_storeu_epi8(o, out_mask, _mm512_permutexvar_epi8(gather, v));
+    return 1;
+}
+
+// p points at an 'M' length char. Returns encoded bytes consumed, 0 if the
+// first line isn't a plain full line.
+static UU_ATTR size_t UU_FN(decode_m_lines_vbmi)(const uint8_t *p, const uint8_t *end,
+                                  uint8_t *out, size_t *out_pos, size_t out_cap)
+{
+    if (end - p < 63)
+        return 0;
+    size_t stride = p[61] == '\n' ? 62 : (p[61] == '\r' && p[62] == '\n') ? 63 : 0;
+    if (stride == 0)
+        return 0;
+
+    __m512i gather = _mm512_loadu_si512((const void *)VBMI_GATHER);
+    const uint8_t *start = p;
+    size_t pos = *out_pos;
+
+    // Up to 4 lines per iteration while room for 4 remains, then one at a time
+    while ((size_t)(end - p) >= 4 * stride && pos + 4 * 45 <= out_cap)
+    {
+        int k = 0;
+        while (k < 4 && UU_FN(decode_line_vbmi)(p, stride, out + pos, gather))
+        {
+            p += stride;
+            pos += 45;
+            k++;
+        }
+        if (k < 4)
+            break;
+    }
+    while ((size_t)(end - p) >= stride && pos + 45 <= out_cap &&
+           UU_FN(decode_line_vbmi)(p, stride, out + pos, gather))
+    {
+        p += stride;
+        pos += 45;
+    }
+
+    *out_pos = pos;
+    return (size_t)(p - start);
+}
+#endif
+
+// Bit-at-a-time decode of nbytes from [p, line_end), zero-padding short lines.
+// Caller guarantees room for nbytes.
+static UU_ATTR inline void UU_FN(decode_short_line)(const uint8_t *p, const uint8_t *line_end,
+                                                    int nbytes, uint8_t *out, size_t *out_pos)
+{
+    size_t pos = *out_pos;
+    uint32_t leftchar = 0;
+    int leftbits = 0;
+    while (nbytes > 0)
+    {
+        uint8_t ch = (p < line_end) ? ((*p++ - 32) & 0x3f) : 0;
+        leftchar = (leftchar << 6) | ch;
+        leftbits += 6;
+        if (leftbits >= 8)
+        {
+            leftbits -= 8;
+            out[pos++] = (leftchar >> leftbits) & 0xff;
+            leftchar &= (1 << leftbits) - 1;
+            nbytes--;
+        }
+    }
+    *out_pos = pos;
+}
+
+// ---------------------------------------------------------------------------
+// Main decode loop
+// ---------------------------------------------------------------------------
+
+static UU_ATTR size_t UU_FN(uudecode)(const uint8_t *in, size_t in_len, uint8_t *out, size_t out_cap)
+{
+    size_t i = 0;
+    size_t out_pos = 0;
+    const uint8_t *buf = in;
+    const uint8_t *end = in + in_len;
+
+    while (i < in_len)
+    {
+        uint8_t len_char = buf[i];
+
+        // Skip blank lines / CRLF
+        if (len_char == '\n' || len_char == '\r')
+        {
+            i++;
+            continue;
+        }
+
+#ifdef UUDECODE_AVX512VBMI
+        if (len_char == 'M')
+        {
+            size_t used = UU_FN(decode_m_lines_vbmi)(buf + i, end, out, &out_pos, out_cap);
+            if (used)
+            {
+                i += used;
+                continue;
+            }
+        }
+#endif
+
+        // Zero-length line = end of uuencoded block
+        int nbytes = (len_char - 32) & 0x3f;
+        if (nbytes == 0)
+            break;
+
+        i++; // consume length char
+
+        // Find end of line (SIMD-accelerated)
+        const uint8_t *line_start = buf + i;
+        const uint8_t *line_end = UU_FN(find_newline)(line_start, end);
+        size_t line_len = (size_t)(line_end - line_start);
+
+        // Advance i past line and newline
+        i += line_len;
+        if (i < in_len && buf[i] == '\r')
+            i++;
+        if (i < in_len && buf[i] == '\n')
+            i++;
+
+        int out_full = 0;
+        if (out_pos + (size_t)nbytes > out_cap)
+        {
+            nbytes = (int)(out_cap - out_pos);
+            out_full = 1;
+        }
+        if (nbytes <= 0)
+            return out_pos;
+
+        // --- FAST PATH: full line, >= 60 encoded chars ---
+        if (!out_full && len_char == 'M' && line_len >= 60 && (line_start + 64 <= end) &&
+            (out_pos + 45 <= out_cap))
+        {
+            UU_FN(decode_full_line)(line_start, out, &out_pos);
+            continue;
+        }
+
+        // --- SLOW PATH: partial or short line ---
+        UU_FN(decode_short_line)(line_start, line_end, nbytes, out, &out_pos);
+
+        if (out_full)
+            return out_pos;
+    }
+
+    return out_pos;
+}
+
+// ---------------------------------------------------------------------------
+// Fused decode loop: same line rules as uudecode, plus the "end" line check
+// that used to be a separate pass over the payload
+// ---------------------------------------------------------------------------
+
+static UU_ATTR inline int UU_FN(is_end_line)(const uint8_t *p, const uint8_t *line_end)
+{
+    if (line_end - p < 3 || p[0] != 'e' || p[1] != 'n' || p[2] != 'd')
+        return 0;
+    return line_end - p == 3 || p[3] == ' ' || p[3] == '\t';
+}
+
+// Offset of the first "end" line at or after line start i, or in_len
+static UU_ATTR size_t UU_FN(find_end_line)(const uint8_t *in, size_t i, size_t in_len)
+{
+    const uint8_t *end = in + in_len;
+    while (i < in_len)
+    {
+        if (in[i] == '\n' || in[i] == '\r')
+        {
+            i++;
+            continue;
+        }
+        const uint8_t *line_end = UU_FN(find_newline)(in + i, end);
+        if (UU_FN(is_end_line)(in + i, line_end))
+            return i;
+        i = (size_t)(line_end - in);
+    }
+    return in_len;
+}
+
+static UU_ATTR int UU_FN(uudecode_fused)(const uint8_t *in, size_t in_len, uint8_t *out,
+                                         size_t out_cap, int cap_is_limit, uu_fused_state *st)
+{
+    size_t i = st->in_pos;
+    size_t out_pos = st->out_pos;
+    const uint8_t *end = in + in_len;
+
+    while (i < in_len)
+    {
+        uint8_t len_char = in[i];
+
+        if (len_char == '\n' || len_char == '\r')
+        {
+            i++;
+            continue;
+        }
+
+#ifdef UUDECODE_AVX512VBMI
+        if (len_char == 'M')
+        {
+            size_t used = UU_FN(decode_m_lines_vbmi)(in + i, end, out, &out_pos, out_cap);
+            if (used)
+            {
+                i += used;
+                continue;
+            }
+        }
+#endif
+
+        const uint8_t *line_end = UU_FN(find_newline)(in + i, end);
+        if (len_char == 'e' && UU_FN(is_end_line)(in + i, line_end))
+        {
+            st->out_pos = out_pos;
+            st->enc_len = i;
+            return UU_FUSED_DONE;
+        }
+
+        // Zero-length line: decoding stops, the "end" line still bounds the payload
+        int nbytes = (len_char - 32) & 0x3f;
+        if (nbytes == 0)
+            break;
+
+        // Stop at a line boundary so the caller can grow out and resume here
+        int out_full = 0;
+        if (out_pos + (size_t)nbytes > out_cap)
+        {
+            if (!cap_is_limit)
+            {
+                st->in_pos = i;
+                st->out_pos = out_pos;
+                return UU_FUSED_FULL;
+            }
+            nbytes = (int)(out_cap - out_pos);
+            out_full = 1;
+            st->truncated = 1;
+        }
+
+        const uint8_t *line_start = in + i + 1;
+        size_t line_len = (size_t)(line_end - line_start);
+        i = (size_t)(line_end - in);
+        if (i < in_len && in[i] == '\r')
+            i++;
+        if (i < in_len && in[i] == '\n')
+            i++;
+
+        if (!out_full && len_char == 'M' && line_len >= 60 && (line_start + 64 <= end))
+            UU_FN(decode_full_line)(line_start, out, &out_pos);
+        else
+            UU_FN(decode_short_line)(line_start, line_end, nbytes, out, &out_pos);
+
+        if (out_full)
+            break;
+    }
+
+    st->out_pos = out_pos;
+    st->enc_len = UU_FN(find_end_line)(in, i, in_len);
+    return UU_FUSED_DONE;
+}
+
+#undef UU_SUFFIX
+#undef UU_ATTR
+#undef UUDECODE_AVX512VBMI
+#undef UUDECODE_AVX2
+#undef UUDECODE_SSSE3
+#undef UUDECODE_SSE2
+#undef UUDECODE_NEON
@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+"""Generates src/standardize_keymap.h, the header key map used by
+standardize_submission_metadata.c.
+
+The table is a perfect hash over the lowercase keys: FNV-1a with a searched
+seed, top KEYMAP_BITS bits as the slot, so every key lands in its own slot and
+a lookup is one hash (computed while lowercasing) and one memcmp.
+
+Edit MAP below and rerun:  python3 tools/gen_keymap.py > src/standardize_keymap.h
+"""
+
+import sys
+
+# (lowercase key as it appears in the header, standardized key, extractor)
+MAP = [
+    ("paper", "paper", "REGEX_NONE"),
+    ("accession number", "accession-number", "REGEX_NONE"),
+    ("conformed submission type", "type", "REGEX_NONE"),
+    ("public document count", "public-document-count", "REGEX_NONE"),
+    ("public document_count", "public-document-count", "REGEX_NONE"),
+    ("conformed period of report", "period", "REGEX_NONE"),
+    ("filed as of date", "filing-date", "REGEX_NONE"),
+    ("date as of change", "date-of-filing-date-change", "REGEX_NONE"),
+    ("effectiveness date", "effectiveness-date", "REGEX_NONE"),
+    ("filer", "filer", "REGEX_NONE"),
+    ("company data", "company-data", "REGEX_NONE"),
+    ("company conformed name", "conformed-name", "REGEX_NONE"),
+    ("central index key", "cik", "REGEX_NONE"),
+    ("state of incorporation", "state-of-incorporation", "REGEX_NONE"),
+    ("fiscal year end", "fiscal-year-end", "REGEX_NONE"),
+    ("filing values", "filing-values", "REGEX_NONE"),
+    ("form type", "form-type", "REGEX_NONE"),
+    ("sec act", "act", "REGEX_SEC_ACT"),
+    ("sec file number", "file-number", "REGEX_NONE"),
+    ("film number", "film-number", "REGEX_NONE"),
+    ("business address", "business-address", "REGEX_NONE"),
+    ("street 1", "street1", "REGEX_NONE"),
+    ("city", "city", "REGEX_NONE"),
+    ("state", "state", "REGEX_NONE"),
+    ("zip", "zip", "REGEX_NONE"),
+    ("business phone", "phone", "REGEX_NONE"),
+    ("mail address", "mail-address", "REGEX_NONE"),
+    ("former company", "former-company", "REGEX_NONE"),
+    ("former conformed name", "former-conformed-name", "REGEX_NONE"),
+    ("date of name change", "date-changed", "REGEX_NONE"),
+    ("sros", "sros", "REGEX_NONE"),
+    ("subject company", "subject-company", "REGEX_NONE"),
+    ("standard industrial classification", "assigned-sic", "REGEX_SIC"),
+    ("irs number", "irs-number", "REGEX_NONE"),
+    ("filed by", "filed-by", "REGEX_NONE"),
+    ("street 2", "street2", "REGEX_NONE"),
+    ("items", "items", "REGEX_NONE"),
+    ("group members", "group-members", "REGEX_NONE"),
+    ("organization name", "organization-name", "REGEX_NONE"),
+    ("recieved date", "recieved-date", "REGEX_NONE"),
+    ("action date", "action-date", "REGEX_NONE"),
+    ("non us state territory", "non-us-state-territory", "REGEX_NONE"),
+    ("address is a non us location", "address-is-a-non-us-location", "REGEX_NONE"),
+    ("ein", "ein", "REGEX_NONE"),
+    ("class-contract-ticker-symbol", "class-contract-ticker-symbol", "REGEX_NONE"),
+    ("class-contract-name", "class-contract-name", "REGEX_NONE"),
+    ("class-contract-id", "class-contract-id", "REGEX_NONE"),
+    ("sec-document", "sec-document", "REGEX_NONE"),
+    ("sec-header", "sec-header", "REGEX_NONE"),
+    ("acceptance-datetime", "acceptance-datetime", "REGEX_NONE"),
+    ("series-and-classes-contracts-data", "series-and-classes-contracts-data", "REGEX_NONE"),
+    ("existing-series-and-classes-contracts", "existing-series-and-classes-contracts", "REGEX_NONE"),
+    ("merger-series-and-classes-contracts", "merger-series-and-classes-contracts", "REGEX_NONE"),
+    ("new-series-and-classes-contracts", "new-series-and-classes-contracts", "REGEX_NONE"),
+    ("series", "series", "REGEX_NONE"),
+    ("owner-cik", "owner-cik", "REGEX_NONE"),
+    ("series-id", "series-id", "REGEX_NONE"),
+    ("series-name", "series-name", "REGEX_NONE"),
+    ("acquiring-data", "acquiring-data", "REGEX_NONE"),
+    ("target-data", "target-data", "REGEX_NONE"),
+    ("new-classes-contracts", "new-classes-contracts", "REGEX_NONE"),
+    ("new-series", "new-series", "REGEX_NONE"),
+    ("relationship", "relationship", "REGEX_NONE"),
+]
+
+FNV_PRIME = 16777619
+
+
+def key_hash(seed, key):
+    h = seed
+    for c in key.encode("ascii"):
+        h = ((h ^ c) * FNV_PRIME) & 0xFFFFFFFF
+    return h
+
+
+def find_seed(keys, bits):
+    for seed in range(1, 1 << 20):
+        slots = set()
+        for k in keys:
+            s = key_hash(seed, k) >> (32 - bits)
+            if s in slots:
+                break
+            slots.add(s)
+        else:
+            return seed
+    return None
+
+
+def main():
+    keys = [m[0] for m in MAP]
+    assert len(set(keys)) == len(keys), "duplicate keys"
+    assert all(k == k.lower() for k in keys), "keys must be lowercase"
+    for bits in range(8, 12):
+        seed = find_seed(keys, bits)
+        if seed is not None:
+            break
+    else:
+        sys.exit("no perfect hash seed found")
+
+    slots = [0] * (1 << bits)
+    for i, k in enumerate(keys):
+        slots[key_hash(seed, k) >> (32 - bits)] = i + 1
+
+    out = sys.stdout
+    out.write("// Generated by tools/gen_keymap.py -- edit the table there and rerun.\n")
+    out.write("// Included only by standardize_submission_metadata.c.\n")
+    out.write("#ifndef STANDARDIZE_KEYMAP_H\n#define STANDARDIZE_KEYMAP_H\n\n")
+    defines = [
+        ("KEYMAP_SEED", "0x%08Xu" % seed, ""),
+        ("KEYMAP_BITS", "%d" % bits, ""),
+        ("KEYMAP_MAX_KEY", "%d" % max(len(k) for k in keys),
+         "longest key; anything longer can't match"),
+    ]
+    for name, value, comment in defines:
+        line = "#define %-14s %s" % (name, value)
+        out.write((line + "  // " + comment if comment else line) + "\n")
+    out.write("\n")
+    out.write("static const map_entry MAP[] = {\n")
+    for k, to, rx in MAP:
+        out.write('    { "%s", %d, "%s", %d, %s },\n' % (k, len(k), to, len(to), rx))
+    out.write("};\n\n")
+    out.write("// MAP index + 1 per hash slot, 0 = empty\n")
+    out.write("static const uint8_t KEYMAP_SLOTS[%d] = {\n" % len(slots))
+    for i in range(0, len(slots), 16):
+        out.write("    " + ", ".join("%2d" % s for s in slots[i:i + 16]) + ",\n")
+    out.write("};\n\n#endif\n")
+
+
+if __name__ == "__main__":
+    main()